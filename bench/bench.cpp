@@ -0,0 +1,546 @@
+// Benchmark de renderização: cenas fixas (semente fixa), vazão de raios,
+// raios secundários ordenados contra a ordem original (com as faltas de
+// cache, no Linux), qualidade em tempo fixo contra uma referência, memória e
+// escala com threads.
+// Resultado em JSON para acompanhar regressões entre versões.
+//
+// Uso (a partir da raiz do projeto):
+//   bench [--out arquivo.json] [--label texto] [--time segundos] [--update-reference]
+//         [--config arquivo] [chave=valor ...]
+//
+// A configuração usa as chaves de render_config.h: width, height, spp (vazão),
+// pass_spp (passadas da qualidade), batch_spp, max_depth, rr_*, threads, scene,
+// cam, target e fov.
+//
+// As referências ficam em bench/reference/<cena>.pfm e são renderizadas na
+// primeira execução (ou quando a cena muda, ou com --update-reference).
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <vector>
+#include <string>
+#include <random>
+#include <cmath>
+#include <cstring>
+#include <algorithm>
+#include <filesystem>
+#include <omp.h>
+#include "../include/vec3.h"
+#include "../include/ray.h"
+#include "../include/sphere.h"
+#include "../include/plane.h"
+#include "../include/obj_loader.h"
+#include "../include/scene.h"
+#include "../include/cornell_box.h"
+#include "../include/sampling.h"
+#include "../include/integrator.h"
+#include "../include/camera.h"
+#include "../include/image_io.h"
+#include "../include/checkpoint.h"
+#include "../include/render_config.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <sys/resource.h>
+#endif
+#ifdef __linux__
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+#endif
+
+// Configurações do benchmark: spp = amostras por pixel nas medidas de vazão,
+// pass_spp = passadas da medida de qualidade em tempo fixo
+RenderConfig bench_defaults() {
+    RenderConfig c;
+    c.width = 128;
+    c.height = 128;
+    c.spp = 16;
+    c.pass_spp = 4;
+    c.batch_spp = 16;
+    return c;
+}
+RenderConfig config = bench_defaults();
+const int REFERENCE_SPP = 512;      // Amostras por pixel das referências
+const uint64_t REFERENCE_SEED = 1000;
+const uint64_t BENCH_SEED = 1;
+
+struct BenchScene {
+    std::string name;
+    Scene scene;
+    Point3 cam_pos, cam_target;
+    float fov;
+};
+
+struct RenderStats {
+    double seconds = 0.0;
+    unsigned long long rays = 0;
+    long long samples = 0;
+    long long l1d_misses = -1;      // Faltas de leitura no L1 de dados (-1 = indisponível)
+    long long llc_misses = -1;      // Faltas no último nível de cache (-1 = indisponível)
+};
+
+// Faltas de cache da thread atual entre a construção e read(), pelos
+// contadores de hardware (perf_event_open, só no Linux). O L2 não tem evento
+// genérico no perf; medimos o L1 de dados e o último nível (LLC). Sem
+// permissão (perf_event_paranoid) ou fora do Linux, os contadores ficam
+// indisponíveis.
+class CacheMissCounter {
+public:
+    explicit CacheMissCounter(bool enabled) {
+#ifdef __linux__
+        if (!enabled) return;
+        fd_[0] = open_event(PERF_TYPE_HW_CACHE, PERF_COUNT_HW_CACHE_L1D | (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+                                                    (PERF_COUNT_HW_CACHE_RESULT_MISS << 16));
+        fd_[1] = open_event(PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES);
+#else
+        (void)enabled;
+#endif
+    }
+
+    ~CacheMissCounter() {
+#ifdef __linux__
+        for (int fd : fd_) if (fd >= 0) close(fd);
+#endif
+    }
+
+    CacheMissCounter(const CacheMissCounter&) = delete;
+    CacheMissCounter& operator=(const CacheMissCounter&) = delete;
+
+    // Contagens desde a construção (-1 = indisponível)
+    void read(long long& l1d, long long& llc) const {
+        l1d = value(fd_[0]);
+        llc = value(fd_[1]);
+    }
+
+private:
+    int fd_[2] = {-1, -1};
+
+#ifdef __linux__
+    static int open_event(uint32_t type, uint64_t config) {
+        perf_event_attr attr;
+        std::memset(&attr, 0, sizeof(attr));
+        attr.size = sizeof(attr);
+        attr.type = type;
+        attr.config = config;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        // pid = 0, cpu = -1: só esta thread, em qualquer CPU
+        return static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0));
+    }
+#endif
+
+    static long long value(int fd) {
+#ifdef __linux__
+        long long count = 0;
+        if (fd >= 0 && ::read(fd, &count, sizeof(count)) == static_cast<ssize_t>(sizeof(count))) return count;
+#else
+        (void)fd;
+#endif
+        return -1;
+    }
+};
+
+// Pico de memória residente do processo (bytes)
+size_t peak_memory_bytes() {
+#ifdef _WIN32
+    PROCESS_MEMORY_COUNTERS counters;
+    if (GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters))) {
+        return counters.PeakWorkingSetSize;
+    }
+    return 0;
+#else
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+#ifdef __APPLE__
+    return static_cast<size_t>(usage.ru_maxrss);
+#else
+    return static_cast<size_t>(usage.ru_maxrss) * 1024;
+#endif
+#endif
+}
+
+// Memória dos dados da cena (primitivas + estruturas de aceleração)
+size_t scene_bytes(const Scene& scene) {
+    size_t bytes = scene.spheres.size() * sizeof(Sphere) + scene.planes.size() * sizeof(Plane) +
+                   scene.triangles.size() * sizeof(Triangle) + scene.triangle_blocks.size() * sizeof(TriangleBlock8);
+    for (const auto& bake : scene.baked_textures) bytes += bake.memory_bytes();
+    return bytes;
+}
+
+// Soma 'spp' amostras por pixel em 'accum' (passada 'pass', semente 'seed').
+// Com 'count_misses', cada thread mede as próprias faltas de cache e a soma
+// vai para o resultado.
+RenderStats render(const BenchScene& bs, std::vector<Color>& accum, int spp, int pass, uint64_t seed,
+                   bool sort_rays = false, bool count_misses = false) {
+    Camera camera(bs.cam_pos, bs.cam_target, bs.fov, config.width, config.height);
+    RenderStats stats;
+    unsigned long long rays_before = total_rays_cast;
+    bool misses_valid = count_misses;
+    long long l1d_total = 0, llc_total = 0;
+    double start = omp_get_wtime();
+
+    #pragma omp parallel
+    {
+        const unsigned long long rays_start = rays_cast;
+        CacheMissCounter misses(count_misses);
+        #pragma omp for schedule(dynamic)
+        for (int r = 0; r < config.height; r++) {
+            int y = config.height - 1 - r;
+            seed_rng(seed, static_cast<uint64_t>(pass) * config.height + y);
+            trace_batched(bs.scene, config.width, spp, config.batch_spp, sort_rays,
+                          [&](int x) { return camera.get_ray(x + random_float(), y + random_float()); },
+                          &accum[static_cast<size_t>(r) * config.width]);
+        }
+        total_rays_cast += rays_cast - rays_start;
+
+        long long l1d, llc;
+        misses.read(l1d, llc);
+        #pragma omp critical(bench_misses)
+        {
+            if (l1d < 0 || llc < 0) misses_valid = false;
+            l1d_total += l1d;
+            llc_total += llc;
+        }
+    }
+
+    stats.seconds = omp_get_wtime() - start;
+    stats.rays = total_rays_cast - rays_before;
+    stats.samples = static_cast<long long>(config.width) * config.height * spp;
+    if (misses_valid) {
+        stats.l1d_misses = l1d_total;
+        stats.llc_misses = llc_total;
+    }
+    return stats;
+}
+
+std::vector<Color> average(const std::vector<Color>& accum, int spp) {
+    std::vector<Color> image(accum.size());
+    for (size_t i = 0; i < accum.size(); i++) image[i] = accum[i] / static_cast<float>(spp);
+    return image;
+}
+
+// RMSE linear ou na tela (clamp + gamma 2.2, como o PNG)
+double rmse(const std::vector<Color>& a, const std::vector<Color>& b, bool display) {
+    auto tonemap = [](float v) { return std::pow(std::clamp(v, 0.0f, 1.0f), 1.0f / 2.2f); };
+    double sum = 0.0;
+    for (size_t i = 0; i < a.size(); i++) {
+        Vec3 d = a[i] - b[i];
+        if (display) {
+            d = Vec3(tonemap(a[i].x) - tonemap(b[i].x), tonemap(a[i].y) - tonemap(b[i].y),
+                     tonemap(a[i].z) - tonemap(b[i].z));
+        }
+        sum += d.x * d.x + d.y * d.y + d.z * d.z;
+    }
+    return std::sqrt(sum / (3.0 * a.size()));
+}
+
+// ----------------------------------------------------------------------------
+// Cenas
+// ----------------------------------------------------------------------------
+
+// Sopa de triângulos: 'count' triângulos pequenos espalhados numa caixa
+BenchScene triangle_soup(int count) {
+    BenchScene bs{"triangle_soup", Scene(), Point3(0, 1, 4), Point3(0, 1, 0), 45.0f};
+    std::mt19937 gen(1234);
+    std::uniform_real_distribution<float> u(0.0f, 1.0f);
+    for (int i = 0; i < count; i++) {
+        Point3 c(u(gen) * 2.0f - 1.0f, u(gen) * 2.0f, u(gen) * 2.0f - 1.0f);
+        auto jitter = [&] { return Vec3(u(gen) - 0.5f, u(gen) - 0.5f, u(gen) - 0.5f) * 0.15f; };
+        Color albedo(0.2f + 0.7f * u(gen), 0.2f + 0.7f * u(gen), 0.2f + 0.7f * u(gen));
+        bs.scene.triangles.push_back(Triangle(c + jitter(), c + jitter(), c + jitter(), albedo));
+    }
+    bs.scene.planes.push_back(Plane(Point3(0, 0, 0), Vec3(0, 1, 0)));
+    bs.scene.spheres.push_back(Sphere(Point3(0, 3.5f, 1), 0.75f, Color(0, 0, 0), DIFFUSE, 0.0f, Color(8, 8, 8)));
+    bs.scene.build();
+    return bs;
+}
+
+// Campo de esferas: grade n x n alternando difuso, metal e textura
+BenchScene sphere_field(int n) {
+    BenchScene bs{"sphere_field", Scene(), Point3(0, 2.5f, 5), Point3(0, 0, 0), 45.0f};
+    std::mt19937 gen(4321);
+    std::uniform_real_distribution<float> u(0.0f, 1.0f);
+    float spacing = 4.0f / n;
+    for (int i = 0; i < n; i++) {
+        for (int j = 0; j < n; j++) {
+            Point3 c(-2.0f + (i + 0.5f) * spacing, spacing * 0.4f, -2.0f + (j + 0.5f) * spacing);
+            Color albedo(0.2f + 0.7f * u(gen), 0.2f + 0.7f * u(gen), 0.2f + 0.7f * u(gen));
+            MaterialType type = (i + j) % 3 == 0 ? METAL : (i + j) % 3 == 1 ? TEXTURED : DIFFUSE;
+            bs.scene.spheres.push_back(Sphere(c, spacing * 0.4f, albedo, type, 0.1f));
+        }
+    }
+    bs.scene.planes.push_back(Plane(Point3(0, 0, 0), Vec3(0, 1, 0)));
+    bs.scene.spheres.push_back(Sphere(Point3(0, 5, 0), 1.5f, Color(0, 0, 0), DIFFUSE, 0.0f, Color(5, 5, 5)));
+    bs.scene.texture_type = TEX_MARBLE;
+    bs.scene.build();
+    return bs;
+}
+
+// Ao ar livre: esferas difusas num plano sob um céu com um sol pequeno e
+// forte (mapa de ambiente 512 x 256 gerado aqui, sol com ~1.7 grau de raio)
+BenchScene outdoor_sun() {
+    BenchScene bs{"outdoor_sun", Scene(), Point3(0, 2.5f, 5), Point3(0, 0, 0), 45.0f};
+    std::mt19937 gen(2468);
+    std::uniform_real_distribution<float> u(0.0f, 1.0f);
+    for (int i = 0; i < 24; i++) {
+        float r = 0.2f + 0.3f * u(gen);
+        Color albedo(0.2f + 0.7f * u(gen), 0.2f + 0.7f * u(gen), 0.2f + 0.7f * u(gen));
+        bs.scene.spheres.push_back(Sphere(Point3(u(gen) * 5.0f - 2.5f, r, u(gen) * 5.0f - 2.5f), r, albedo));
+    }
+    bs.scene.planes.push_back(Plane(Point3(0, 0, 0), Vec3(0, 1, 0)));
+
+    const int w = 512, h = 256;
+    const Vec3 sun = Vec3(0.5f, 0.7f, -0.5f).normalized();
+    const float pi = static_cast<float>(M_PI);
+    std::vector<Color> sky(static_cast<size_t>(w) * h);
+    for (int y = 0; y < h; y++) {
+        for (int x = 0; x < w; x++) {
+            float theta = (y + 0.5f) * pi / h, phi = ((x + 0.5f) / w - 0.5f) * 2.0f * pi;
+            Vec3 d(std::sin(theta) * std::sin(phi), std::cos(theta), -std::sin(theta) * std::cos(phi));
+            Color c = d.y > 0.0f ? Color(0.3f, 0.5f, 0.9f) * (0.3f + 0.7f * d.y) : Color(0.1f, 0.1f, 0.1f);
+            if (Vec3::dot(d, sun) > std::cos(0.03f)) c = Color(5000, 4500, 4000);
+            sky[static_cast<size_t>(y) * w + x] = c;
+        }
+    }
+    bs.scene.environment.build(w, h, std::move(sky), 1.0f, 0.0f);
+    bs.scene.build();
+    return bs;
+}
+
+// Cornell Box com todas as superfícies em mármore (6 oitavas de ruído por acerto)
+BenchScene texture_heavy() {
+    BenchScene bs{"texture_heavy", load_cornell_box(), Point3(0, 1, 3), Point3(0, 1, 0), 40.0f};
+    for (auto& tri : bs.scene.triangles) tri.mat_type = TEXTURED;
+    bs.scene.texture_type = TEX_MARBLE;
+    bs.scene.build();
+    return bs;
+}
+
+// ----------------------------------------------------------------------------
+
+// Carrega a referência da cena, renderizando de novo se ela faltar ou se a cena mudou
+bool reference_image(const BenchScene& bs, bool update, std::vector<Color>& reference) {
+    namespace fs = std::filesystem;
+    fs::create_directories("bench/reference");
+    std::string pfm = "bench/reference/" + bs.name + ".pfm";
+    std::string hash_file = "bench/reference/" + bs.name + ".hash";
+
+    Hasher hasher;
+    hasher.add(scene_hash(bs.scene));
+    hasher.add(bs.cam_pos); hasher.add(bs.cam_target); hasher.add(bs.fov);
+    hasher.add(config.width); hasher.add(config.height); hasher.add(REFERENCE_SPP);
+    hasher.add(integrator_settings.max_depth); hasher.add(integrator_settings.rr_depth);
+    hasher.add(integrator_settings.rr_min_survival); hasher.add(integrator_settings.rr_max_survival);
+
+    uint64_t stored = 0;
+    std::ifstream(hash_file) >> stored;
+    int w = 0, h = 0;
+    if (!update && stored == hasher.value && read_pfm(pfm, w, h, reference) && w == config.width && h == config.height) {
+        return true;
+    }
+
+    std::cout << "  renderizando referência (" << REFERENCE_SPP << " spp)..." << std::flush;
+    std::vector<Color> accum(static_cast<size_t>(config.width) * config.height, Color(0, 0, 0));
+    RenderStats stats = render(bs, accum, REFERENCE_SPP, 0, REFERENCE_SEED);
+    std::cout << " " << stats.seconds << " s" << std::endl;
+    reference = average(accum, REFERENCE_SPP);
+    if (!write_pfm(pfm, config.width, config.height, reference.data())) return false;
+    std::ofstream(hash_file) << hasher.value << "\n";
+    return true;
+}
+
+// Faltas de cache no console ("indisponível" sem contador)
+std::string misses_text(long long count) {
+    return count < 0 ? "indisponível" : std::to_string(count);
+}
+
+// Faltas de cache no JSON (null sem contador)
+std::string misses_json(long long count) {
+    return count < 0 ? "null" : std::to_string(count);
+}
+
+std::string json_escape(const std::string& s) {
+    std::string out;
+    for (char c : s) {
+        if (c == '"' || c == '\\') out += '\\';
+        out += c;
+    }
+    return out;
+}
+
+int main(int argc, char** argv) {
+    std::string out_path = "bench_results.json";
+    std::string label;
+    double time_budget = 2.0;
+    bool update_reference = false;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--out" && i + 1 < argc) out_path = argv[++i];
+        else if (arg == "--label" && i + 1 < argc) label = argv[++i];
+        else if (arg == "--time" && i + 1 < argc) time_budget = std::stod(argv[++i]);
+        else if (arg == "--update-reference") update_reference = true;
+        else if (arg == "--config" && i + 1 < argc) {
+            std::string error;
+            if (!config.load(argv[++i], error)) {
+                std::cerr << "ERRO: " << error << std::endl;
+                return 1;
+            }
+        } else if (arg.find('=') != std::string::npos && arg.compare(0, 2, "--") != 0) {
+            std::string error;
+            if (!config.set(arg, error)) {
+                std::cerr << "ERRO: " << error << std::endl;
+                return 1;
+            }
+        } else {
+            std::cerr << "Argumento desconhecido: " << arg << std::endl;
+            return 1;
+        }
+    }
+
+    std::string error;
+    if (!config.validate(error)) {
+        std::cerr << "ERRO: configuração inválida: " << error << std::endl;
+        return 1;
+    }
+    integrator_settings = config.integrator;
+    int max_threads = config.threads > 0 ? config.threads : omp_get_max_threads();
+    omp_set_num_threads(max_threads);
+    std::ostringstream json;
+    json << std::setprecision(6);
+    json << "{\n  \"label\": \"" << json_escape(label) << "\",\n"
+         << "  \"width\": " << config.width << ",\n  \"height\": " << config.height << ",\n"
+         << "  \"threads\": " << max_threads << ",\n  \"time_budget_sec\": " << time_budget << ",\n"
+         << "  \"scenes\": [\n";
+
+    std::vector<BenchScene> scenes;
+    scenes.push_back({std::filesystem::path(config.scene).stem().string(), load_cornell_box(config.scene),
+                      config.cam_pos, config.cam_target, config.fov});
+    scenes.push_back(triangle_soup(4096));
+    scenes.push_back(sphere_field(16));
+    scenes.push_back(texture_heavy());
+    scenes.push_back(outdoor_sun());
+
+    for (size_t s = 0; s < scenes.size(); s++) {
+        const BenchScene& bs = scenes[s];
+        if (bs.scene.triangles.empty() && bs.scene.spheres.empty()) {
+            std::cerr << "ERRO: cena vazia: " << bs.name << std::endl;
+            return 1;
+        }
+        std::cout << "== " << bs.name << " (" << bs.scene.triangles.size() << " triângulos, "
+                  << bs.scene.spheres.size() << " esferas) ==" << std::endl;
+
+        std::vector<Color> reference;
+        if (!reference_image(bs, update_reference, reference)) {
+            std::cerr << "ERRO: não foi possível gravar a referência de " << bs.name << std::endl;
+            return 1;
+        }
+
+        // Vazão: aquecimento + medida com spp fixo
+        std::vector<Color> accum(static_cast<size_t>(config.width) * config.height, Color(0, 0, 0));
+        render(bs, accum, 1, 0, BENCH_SEED);
+        std::fill(accum.begin(), accum.end(), Color(0, 0, 0));
+        RenderStats stats = render(bs, accum, config.spp, 0, BENCH_SEED);
+        double primary = static_cast<double>(stats.samples);
+        double secondary = static_cast<double>(stats.rays) - primary;
+
+        // Raios secundários ordenados (sort_rays) contra a ordem original:
+        // melhor vazão de 3 medidas alternadas e as faltas de cache de uma medida
+        double sort_rates[2] = {0.0, 0.0};
+        RenderStats sort_runs[2];
+        for (int k = 0; k < 3; k++) {
+            for (int sorted = 0; sorted < 2; sorted++) {
+                std::fill(accum.begin(), accum.end(), Color(0, 0, 0));
+                RenderStats run = render(bs, accum, config.spp, 0, BENCH_SEED, sorted != 0, k == 0);
+                sort_rates[sorted] = std::max(sort_rates[sorted], run.rays / run.seconds);
+                if (k == 0) sort_runs[sorted] = run;
+            }
+        }
+        double sort_speedup = sort_rates[1] / sort_rates[0];
+
+        // Qualidade em tempo fixo: passadas de pass_spp até estourar o orçamento
+        std::fill(accum.begin(), accum.end(), Color(0, 0, 0));
+        int spp_done = 0;
+        double elapsed = 0.0;
+        for (int pass = 0; elapsed < time_budget; pass++) {
+            elapsed += render(bs, accum, config.pass_spp, pass, BENCH_SEED).seconds;
+            spp_done += config.pass_spp;
+        }
+        std::vector<Color> image = average(accum, spp_done);
+        double error = rmse(image, reference, false);
+        double error_display = rmse(image, reference, true);
+
+        std::cout << "  " << (stats.rays / stats.seconds / 1e6) << " Mraios/s (primários "
+                  << (primary / stats.seconds / 1e6) << ", secundários " << (secondary / stats.seconds / 1e6)
+                  << ") | " << (stats.samples / stats.seconds / 1e6) << " Mamostras/s" << std::endl;
+        std::cout << "  " << spp_done << " spp em " << elapsed << " s: RMSE " << error
+                  << " (tela " << error_display << ")" << std::endl;
+        std::cout << "  raios ordenados: x" << sort_speedup << " (" << (sort_rates[0] / 1e6) << " -> "
+                  << (sort_rates[1] / 1e6) << " Mraios/s) | faltas L1d " << misses_text(sort_runs[0].l1d_misses)
+                  << " -> " << misses_text(sort_runs[1].l1d_misses) << ", LLC "
+                  << misses_text(sort_runs[0].llc_misses) << " -> " << misses_text(sort_runs[1].llc_misses)
+                  << std::endl;
+
+        json << "    {\n"
+             << "      \"name\": \"" << bs.name << "\",\n"
+             << "      \"triangles\": " << bs.scene.triangles.size() << ",\n"
+             << "      \"spheres\": " << bs.scene.spheres.size() << ",\n"
+             << "      \"scene_bytes\": " << scene_bytes(bs.scene) << ",\n"
+             << "      \"spp\": " << config.spp << ",\n"
+             << "      \"seconds\": " << stats.seconds << ",\n"
+             << "      \"rays_per_sec\": " << (stats.rays / stats.seconds) << ",\n"
+             << "      \"primary_rays_per_sec\": " << (primary / stats.seconds) << ",\n"
+             << "      \"secondary_rays_per_sec\": " << (secondary / stats.seconds) << ",\n"
+             << "      \"samples_per_sec\": " << (stats.samples / stats.seconds) << ",\n"
+             << "      \"quality_spp\": " << spp_done << ",\n"
+             << "      \"quality_seconds\": " << elapsed << ",\n"
+             << "      \"rmse\": " << error << ",\n"
+             << "      \"rmse_display\": " << error_display << ",\n"
+             << "      \"unsorted_rays_per_sec\": " << sort_rates[0] << ",\n"
+             << "      \"sorted_rays_per_sec\": " << sort_rates[1] << ",\n"
+             << "      \"sort_speedup\": " << sort_speedup << ",\n"
+             << "      \"unsorted_l1d_misses\": " << misses_json(sort_runs[0].l1d_misses) << ",\n"
+             << "      \"sorted_l1d_misses\": " << misses_json(sort_runs[1].l1d_misses) << ",\n"
+             << "      \"unsorted_llc_misses\": " << misses_json(sort_runs[0].llc_misses) << ",\n"
+             << "      \"sorted_llc_misses\": " << misses_json(sort_runs[1].llc_misses) << ",\n"
+             << "      \"peak_memory_bytes\": " << peak_memory_bytes() << "\n"
+             << "    }" << (s + 1 < scenes.size() ? "," : "") << "\n";
+    }
+    json << "  ],\n  \"scaling\": [\n";
+
+    // Escala com threads na Cornell Box: 1, 2, 4, ... até o máximo
+    std::vector<int> thread_counts;
+    for (int t = 1; t < max_threads; t *= 2) thread_counts.push_back(t);
+    thread_counts.push_back(max_threads);
+
+    std::cout << "== Escala com threads (" << scenes[0].name << ") ==" << std::endl;
+    double base_rate = 0.0;
+    std::vector<Color> accum(static_cast<size_t>(config.width) * config.height, Color(0, 0, 0));
+    for (size_t k = 0; k < thread_counts.size(); k++) {
+        omp_set_num_threads(thread_counts[k]);
+        RenderStats stats = render(scenes[0], accum, config.spp, 0, BENCH_SEED);
+        double rate = stats.rays / stats.seconds;
+        if (k == 0) base_rate = rate;
+        double speedup = rate / base_rate;
+        std::cout << "  " << thread_counts[k] << " threads: " << (rate / 1e6) << " Mraios/s (x"
+                  << speedup << ")" << std::endl;
+        json << "    {\"threads\": " << thread_counts[k] << ", \"rays_per_sec\": " << rate
+             << ", \"speedup\": " << speedup << ", \"efficiency\": " << (speedup / thread_counts[k]) << "}"
+             << (k + 1 < thread_counts.size() ? "," : "") << "\n";
+    }
+    omp_set_num_threads(max_threads);
+    json << "  ],\n  \"peak_memory_bytes\": " << peak_memory_bytes() << "\n}\n";
+
+    std::ofstream out(out_path);
+    out << json.str();
+    if (!out) {
+        std::cerr << "ERRO: não foi possível gravar " << out_path << std::endl;
+        return 1;
+    }
+    std::cout << "Resultados salvos em: " << out_path << std::endl;
+    return 0;
+}
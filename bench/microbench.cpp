@@ -0,0 +1,351 @@
+// Microbenchmarks dos kernels: camada SIMD (escalar x SSE x AVX), interseção,
+// amostragem, escolha de luzes e texturas procedurais, em ns por chamada e milhões de chamadas/s
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <random>
+#include <chrono>
+#include <string>
+#include <sstream>
+#include "../include/vec3.h"
+#include "../include/simd.h"
+#include "../include/sphere.h"
+#include "../include/plane.h"
+#include "../include/sampling.h"
+#include "../include/obj_loader.h"
+#include "../include/triangle_block.h"
+#include "../include/lights.h"
+#include "../include/perlin.h"
+#include "../include/solid_texture.h"
+#include "../include/texture_bake.h"
+
+// Impede que o compilador elimine o resultado de um kernel
+static volatile float sink;
+
+template <typename F>
+void run(const std::string& name, long long ops_per_call, F kernel) {
+    using clock = std::chrono::steady_clock;
+
+    // Aquecimento + calibração: repete até passar de ~0.2 s
+    long long reps = 1;
+    double seconds = 0.0;
+    while (true) {
+        auto t0 = clock::now();
+        for (long long i = 0; i < reps; i++) kernel();
+        seconds = std::chrono::duration<double>(clock::now() - t0).count();
+        if (seconds > 0.2) break;
+        reps *= 2;
+    }
+
+    double ops = static_cast<double>(reps) * ops_per_call;
+    std::cout << std::left << std::setw(34) << name
+              << std::right << std::setw(10) << std::fixed << std::setprecision(3) << (seconds * 1e9 / ops) << " ns/op"
+              << std::setw(12) << std::setprecision(1) << (ops / seconds / 1e6) << " Mops/s" << std::endl;
+}
+
+// Fração dos raios que acertam a primitiva (confere que o conjunto mede o caso desejado)
+template <typename P>
+float hit_ratio(const P& prim, const std::vector<Ray>& rays) {
+    HitRecord rec;
+    int hits = 0;
+    for (const auto& r : rays) hits += prim.hit(r, 0.001f, 1e30f, rec);
+    return static_cast<float>(hits) / rays.size();
+}
+
+// Testa cada raio do conjunto contra a primitiva
+template <typename P>
+void run_hit(const std::string& name, const P& prim, const std::vector<Ray>& rays) {
+    std::ostringstream label;
+    label << name << " (" << std::fixed << std::setprecision(0) << hit_ratio(prim, rays) * 100.0f << "% acertos)";
+    run(label.str(), static_cast<long long>(rays.size()), [&] {
+        HitRecord rec;
+        float acc = 0.0f;
+        for (const auto& r : rays) {
+            if (prim.hit(r, 0.001f, 1e30f, rec)) acc += rec.t;
+        }
+        sink = acc;
+    });
+}
+
+int main() {
+    const int N = 4096; // Cabe no L1/L2: mede a computação, não a memória
+    std::mt19937 gen(1234);
+    std::uniform_real_distribution<float> d(-1.0f, 1.0f);
+
+    std::vector<Vec3> a(N), b(N);
+    for (int i = 0; i < N; i++) {
+        a[i] = Vec3(d(gen), d(gen), d(gen));
+        b[i] = Vec3(d(gen), d(gen), d(gen));
+    }
+
+    std::cout << "== Vec3 (escalar) ==" << std::endl;
+    run("dot", N, [&] {
+        float acc = 0.0f;
+        for (int i = 0; i < N; i++) acc += Vec3::dot(a[i], b[i]);
+        sink = acc;
+    });
+    run("cross", N, [&] {
+        Vec3 acc;
+        for (int i = 0; i < N; i++) acc = acc + Vec3::cross(a[i], b[i]);
+        sink = acc.x + acc.y + acc.z;
+    });
+    run("normalized", N, [&] {
+        Vec3 acc;
+        for (int i = 0; i < N; i++) acc = acc + a[i].normalized();
+        sink = acc.x + acc.y + acc.z;
+    });
+
+#ifdef PT_SIMD_SSE
+    std::vector<Vec3A> aa(N), ba(N);
+    for (int i = 0; i < N; i++) {
+        aa[i] = Vec3A(a[i]);
+        ba[i] = Vec3A(b[i]);
+    }
+
+    std::cout << "== Vec3A (SSE, 4-wide) ==" << std::endl;
+    run("dot", N, [&] {
+        float acc = 0.0f;
+        for (int i = 0; i < N; i++) acc += Vec3A::dot(aa[i], ba[i]);
+        sink = acc;
+    });
+    run("cross", N, [&] {
+        Vec3A acc;
+        for (int i = 0; i < N; i++) acc = acc + Vec3A::cross(aa[i], ba[i]);
+        Vec3 r = acc.to_vec3();
+        sink = r.x + r.y + r.z;
+    });
+    run("normalized_fast", N, [&] {
+        Vec3A acc;
+        for (int i = 0; i < N; i++) acc = acc + aa[i].normalized_fast();
+        Vec3 r = acc.to_vec3();
+        sink = r.x + r.y + r.z;
+    });
+#endif
+
+#ifdef PT_SIMD_AVX2
+    // SoA: 8 vetores por registrador
+    struct alignas(32) Soa { float x[N], y[N], z[N]; };
+    std::vector<Soa> soa(2);
+    for (int i = 0; i < N; i++) {
+        soa[0].x[i] = a[i].x; soa[0].y[i] = a[i].y; soa[0].z[i] = a[i].z;
+        soa[1].x[i] = b[i].x; soa[1].y[i] = b[i].y; soa[1].z[i] = b[i].z;
+    }
+
+    auto reduce = [](__m256 v) {
+        alignas(32) float f[8];
+        _mm256_store_ps(f, v);
+        return f[0] + f[1] + f[2] + f[3] + f[4] + f[5] + f[6] + f[7];
+    };
+
+    std::cout << "== Vec3x8 (AVX2+FMA, 8-wide SoA) ==" << std::endl;
+    run("dot", N, [&] {
+        __m256 acc = _mm256_setzero_ps();
+        for (int i = 0; i < N; i += 8) {
+            Vec3x8 va = Vec3x8::load(&soa[0].x[i], &soa[0].y[i], &soa[0].z[i]);
+            Vec3x8 vb = Vec3x8::load(&soa[1].x[i], &soa[1].y[i], &soa[1].z[i]);
+            acc = _mm256_add_ps(acc, Vec3x8::dot(va, vb));
+        }
+        sink = reduce(acc);
+    });
+    run("cross", N, [&] {
+        Vec3x8 acc;
+        for (int i = 0; i < N; i += 8) {
+            Vec3x8 va = Vec3x8::load(&soa[0].x[i], &soa[0].y[i], &soa[0].z[i]);
+            Vec3x8 vb = Vec3x8::load(&soa[1].x[i], &soa[1].y[i], &soa[1].z[i]);
+            acc = acc + Vec3x8::cross(va, vb);
+        }
+        sink = reduce(acc.x) + reduce(acc.y) + reduce(acc.z);
+    });
+    run("normalized_fast", N, [&] {
+        Vec3x8 acc;
+        for (int i = 0; i < N; i += 8) {
+            Vec3x8 va = Vec3x8::load(&soa[0].x[i], &soa[0].y[i], &soa[0].z[i]);
+            acc = acc + va.normalized_fast();
+        }
+        sink = reduce(acc.x) + reduce(acc.y) + reduce(acc.z);
+    });
+#endif
+
+    // Primitivas isoladas: R raios aleatórios por conjunto, separados em
+    // conjuntos que só acertam e que só erram (os dois caminhos têm custos diferentes)
+    const int R = 4096;
+    auto random_unit = [&] { return Vec3(d(gen), d(gen), d(gen) + 1e-3f).normalized(); };
+    // Vetor unitário perpendicular a 'v'
+    auto perpendicular = [&](const Vec3& v) { return Vec3::cross(v, random_unit()).normalized(); };
+
+    Sphere sphere(Point3(0, 0, 0), 1.0f, Color(1, 1, 1));
+    std::vector<Ray> sphere_hit(R), sphere_miss(R);
+    for (int i = 0; i < R; i++) {
+        // Origem a 5 unidades do centro, mirando dentro (acerto) ou fora (erro) da silhueta
+        Point3 o = random_unit() * 5.0f;
+        Vec3 side = perpendicular(o);
+        float u = (d(gen) + 1.0f) * 0.5f;
+        sphere_hit[i] = Ray(o, (side * (0.9f * u) - o).normalized());
+        sphere_miss[i] = Ray(o, (side * (1.2f + 2.0f * u) - o).normalized());
+    }
+
+    Plane plane(Point3(0, 0, 0), Vec3(0, 1, 0));
+    std::vector<Ray> plane_hit(R), plane_miss(R);
+    for (int i = 0; i < R; i++) {
+        // Origem acima do plano; desce (acerto) ou sobe (erro)
+        Point3 o(d(gen) * 4.0f, 0.1f + (d(gen) + 1.0f) * 2.0f, d(gen) * 4.0f);
+        Vec3 dir = random_unit();
+        dir.y = -std::abs(dir.y) - 0.05f;
+        plane_hit[i] = Ray(o, dir.normalized());
+        dir.y = -dir.y;
+        plane_miss[i] = Ray(o, dir.normalized());
+    }
+
+    Triangle triangle(Point3(-1, -1, 0), Point3(1, -1, 0), Point3(0, 1, 0), Color(1, 1, 1));
+    std::vector<Ray> tri_hit(R), tri_miss(R);
+    for (int i = 0; i < R; i++) {
+        // Mira num ponto do plano do triângulo, (u, v) = s * (a, 1 - a) em
+        // coordenadas baricêntricas: dentro com s < 0.95, fora com 1.05 < s < 2
+        float a = (d(gen) + 1.0f) * 0.5f;
+        float s_in = 0.95f * (d(gen) + 1.0f) * 0.5f;
+        float s_out = 1.05f + 0.95f * (d(gen) + 1.0f) * 0.5f;
+        auto target = [&](float s) {
+            return triangle.v0 + (triangle.v1 - triangle.v0) * (s * a) + (triangle.v2 - triangle.v0) * (s * (1.0f - a));
+        };
+        Point3 o(d(gen), d(gen), -3.0f - (d(gen) + 1.0f));
+        tri_hit[i] = Ray(o, (target(s_in) - o).normalized());
+        tri_miss[i] = Ray(o, (target(s_out) - o).normalized());
+    }
+
+    std::cout << "== Primitivas (por teste raio-primitiva) ==" << std::endl;
+    run_hit("Sphere::hit", sphere, sphere_hit);
+    run_hit("Sphere::hit", sphere, sphere_miss);
+    run_hit("Plane::hit", plane, plane_hit);
+    run_hit("Plane::hit", plane, plane_miss);
+    run_hit("Triangle::hit", triangle, tri_hit);
+    run_hit("Triangle::hit", triangle, tri_miss);
+
+    // Amostragem da hemisfera em torno de normais aleatórias
+    std::vector<Vec3> normals(N);
+    for (int i = 0; i < N; i++) normals[i] = random_unit();
+    seed_rng(1234, 0);
+
+    std::cout << "== Amostragem ==" << std::endl;
+    run("cosine_sample_hemisphere", N, [&] {
+        Vec3 acc;
+        for (int i = 0; i < N; i++) acc = acc + cosine_sample_hemisphere(normals[i]);
+        sink = acc.x + acc.y + acc.z;
+    });
+
+    // Escolha de luz entre 4096 triângulos emissivos pequenos espalhados, a
+    // partir de pontos aleatórios (pela potência x pela hierarquia)
+    std::vector<Triangle> emitters;
+    for (int i = 0; i < 4096; i++) {
+        Point3 c(d(gen) * 4.0f, d(gen) * 4.0f, d(gen) * 4.0f);
+        Triangle tri(c, c + random_unit() * 0.05f, c + random_unit() * 0.05f, Color(1, 1, 1));
+        tri.emission = Color(1, 1, 1) * (1.0f + 9.0f * (d(gen) * 0.5f + 0.5f));
+        emitters.push_back(tri);
+    }
+    std::vector<Sphere> no_spheres;
+    LightSampler lights;
+    lights.build(emitters, no_spheres);
+    std::vector<Point3> shading_points(N);
+    for (int i = 0; i < N; i++) shading_points[i] = Point3(d(gen), d(gen), d(gen)) * 4.0f;
+
+    std::cout << "== Luzes (4096 triangulos) ==" << std::endl;
+    for (LightSelection mode : {LIGHT_SELECT_POWER, LIGHT_SELECT_BVH}) {
+        run(mode == LIGHT_SELECT_BVH ? "LightSampler::sample (hierarquia)" : "LightSampler::sample (potencia)", N, [&] {
+            float acc = 0.0f;
+            LightSample ls;
+            for (int i = 0; i < N; i++) {
+                float u = (i + 0.5f) / N;
+                if (lights.sample(mode, shading_points[i], normals[i], u, 0.3f, 0.6f, ls)) acc += ls.pdf_area;
+            }
+            sink = acc;
+        });
+    }
+
+    // Interseção raio-triângulo: um raio contra T triângulos aleatórios
+    const int T = 1024;
+    std::vector<Triangle> tris;
+    for (int i = 0; i < T; i++) {
+        Point3 c(d(gen), d(gen), d(gen));
+        tris.push_back(Triangle(c, c + Vec3(d(gen), d(gen), d(gen)) * 0.2f,
+                                c + Vec3(d(gen), d(gen), d(gen)) * 0.2f, Color(1, 1, 1)));
+    }
+    Ray ray(Point3(0, 0, -3), Vec3(0.05f, 0.02f, 1.0f).normalized());
+
+    std::cout << "== Triangulo (um raio x 1024 triangulos, por teste) ==" << std::endl;
+    run("Triangle::hit (escalar)", T, [&] {
+        HitRecord rec;
+        float closest = 1e30f;
+        for (const auto& tri : tris) {
+            if (tri.hit(ray, 0.001f, closest, rec)) closest = rec.t;
+        }
+        sink = closest;
+    });
+
+#ifdef PT_SIMD_AVX2
+    std::vector<TriangleBlock8> blocks = build_triangle_blocks(tris);
+    run("TriangleBlock8::hit (AVX2)", T, [&] {
+        Vec3x8 orig(ray.origin), dir(ray.direction);
+        float closest = 1e30f;
+        for (const auto& block : blocks) {
+            float t;
+            if (block.hit(orig, dir, 0.001f, closest, t) >= 0) closest = t;
+        }
+        sink = closest;
+    });
+#endif
+
+    // Ruído de Perlin: 6 oitavas por ponto, pontos espalhados em [-4, 4]^3
+    PerlinNoise perlin(42);
+    std::vector<float> px(N), py(N), pz(N), noise_out(N);
+    for (int i = 0; i < N; i++) {
+        px[i] = d(gen) * 4.0f;
+        py[i] = d(gen) * 4.0f;
+        pz[i] = d(gen) * 4.0f;
+    }
+
+    std::cout << "== Perlin ==" << std::endl;
+    run("PerlinNoise::noise (1 oitava)", N, [&] {
+        float acc = 0.0f;
+        for (int i = 0; i < N; i++) acc += perlin.noise(px[i], py[i], pz[i]);
+        sink = acc;
+    });
+    run("octave_noise (6 oitavas)", N, [&] {
+        float acc = 0.0f;
+        for (int i = 0; i < N; i++) acc += perlin.octave_noise(px[i], py[i], pz[i], 6);
+        sink = acc;
+    });
+    run("octave_noise_batch (6 oitavas)", N, [&] {
+        perlin.octave_noise_batch(px.data(), py.data(), pz.data(), noise_out.data(), N, 6);
+        sink = noise_out[N - 1];
+    });
+
+    SolidTexture tex(42);
+    std::vector<Point3> tex_points(N);
+    std::vector<Color> tex_colors(N);
+    for (int i = 0; i < N; i++) tex_points[i] = Point3(px[i], py[i], pz[i]) * 0.25f;
+
+    run("SolidTexture::wood", N, [&] {
+        Color acc;
+        for (int i = 0; i < N; i++) acc = acc + tex.wood(tex_points[i]);
+        sink = acc.x + acc.y + acc.z;
+    });
+    run("SolidTexture::wood_batch", N, [&] {
+        tex.wood_batch(tex_points.data(), tex_colors.data(), N);
+        sink = tex_colors[N - 1].x;
+    });
+    run("SolidTexture::marble (6 oitavas)", N, [&] {
+        Color acc;
+        for (int i = 0; i < N; i++) acc = acc + tex.marble(tex_points[i]);
+        sink = acc.x + acc.y + acc.z;
+    });
+
+    // Cache 3D da mesma textura sobre a caixa dos pontos (64 amostras por eixo)
+    BakedTexture3D baked;
+    baked.bake(tex, TEX_MARBLE, Point3(-1, -1, -1), Point3(1, 1, 1), 64);
+    run("BakedTexture3D::lookup (64^3)", N, [&] {
+        Color acc;
+        for (int i = 0; i < N; i++) acc = acc + baked.lookup(tex_points[i]);
+        sink = acc.x + acc.y + acc.z;
+    });
+
+    return 0;
+}
@@ -1,18 +1,47 @@
 @echo off
 echo Compilando Path Tracer...
 
-g++ -O3 -march=native -fopenmp -std=c++17 ^
+rem Estatisticas do integrador (stats.h): chame "build.bat stats" para
+rem compilar com -DPT_STATS (contadores e tempos por fase, com custo extra)
+set EXTRA_FLAGS=
+if "%1"=="stats" set EXTRA_FLAGS=-DPT_STATS
+
+g++ -O3 -march=native -fopenmp -std=c++17 %EXTRA_FLAGS% ^
     src/main.cpp src/stb_impl.cpp ^
     -I include ^
     -o pathtracer.exe
 
-if %ERRORLEVEL% EQU 0 (
-    echo.
-    echo Compilacao concluida com sucesso!
-    echo Execute: pathtracer.exe
-) else (
-    echo.
-    echo Erro na compilacao!
-)
+if %ERRORLEVEL% NEQ 0 goto erro
+
+echo Compilando microbenchmarks...
+
+g++ -O3 -march=native -fopenmp -std=c++17 ^
+    bench/microbench.cpp ^
+    -I include ^
+    -o microbench.exe
+
+if %ERRORLEVEL% NEQ 0 goto erro
+
+echo Compilando benchmark de renderizacao...
+
+g++ -O3 -march=native -fopenmp -std=c++17 ^
+    bench/bench.cpp ^
+    -I include ^
+    -o bench.exe -lpsapi
+
+if %ERRORLEVEL% NEQ 0 goto erro
+
+echo.
+echo Compilacao concluida com sucesso!
+echo Execute: pathtracer.exe
+echo Microbenchmarks: microbench.exe
+echo Benchmark de renderizacao: bench.exe (resultados em bench_results.json)
+goto fim
+
+:erro
+echo.
+echo Erro na compilacao!
+
+:fim
 
 pause
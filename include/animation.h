@@ -0,0 +1,103 @@
+#ifndef ANIMATION_H
+#define ANIMATION_H
+
+#include <cmath>
+#include <cstdio>
+#include <string>
+#include <vector>
+#include <iostream>
+#include <algorithm>
+#include "vec3.h"
+#include "obj_loader.h"
+#include "cornell_box.h"
+
+// Sequência de quadros: a geometria dos triângulos muda a cada quadro e a
+// cena só é atualizada (Scene::update, refit da BVH) em vez de reconstruída.
+//
+// Duas fontes de movimento, combináveis:
+//  - giro de um objeto (grupo 'usemtl' do OBJ) em torno do eixo vertical que
+//    passa pelo centro da sua caixa no quadro 0 (toca-discos);
+//  - sequência de OBJ com as posições dos vértices de cada quadro (malhas
+//    deformáveis), com o nome dado por um padrão printf ("anim/f_%04d.obj").
+//    Os arquivos passam pela mesma transformação do OBJ da cena.
+//
+// As texturas sólidas são avaliadas no espaço do mundo: num objeto que se
+// move o padrão fica parado e o objeto "atravessa" a madeira.
+
+struct ObjectSpin {
+    int object_id;
+    float degrees_per_frame;
+};
+
+class Animation {
+public:
+    int frames = 0;                 // 0 = imagem única
+    std::vector<ObjectSpin> spins;
+    std::string mesh_sequence;      // Padrão printf dos OBJ por quadro (vazio = sem sequência)
+
+    // Guarda a pose do quadro 0 e a transformação aplicada ao OBJ da cena
+    void set_rest_pose(const std::vector<Triangle>& triangles, const MeshTransform& transform) {
+        rest_ = triangles;
+        transform_ = transform;
+    }
+
+    // Triângulos do quadro 'frame'. false se o OBJ do quadro não carregar.
+    bool pose(int frame, std::vector<Triangle>& triangles) const {
+        if (mesh_sequence.empty()) {
+            triangles = rest_;
+        } else {
+            char path[1024];
+            std::snprintf(path, sizeof(path), mesh_sequence.c_str(), frame);
+            std::vector<Triangle> mesh = OBJLoader::load(path);
+            if (mesh.empty()) return false;
+            transform_.apply(mesh);
+            triangles = std::move(mesh);
+        }
+
+        for (const ObjectSpin& spin : spins) {
+            Point3 pivot;
+            if (!object_center(spin.object_id, pivot)) continue;
+            const float angle = spin.degrees_per_frame * frame * 3.14159265f / 180.0f;
+            const float c = std::cos(angle), s = std::sin(angle);
+            auto rotate = [&](Point3& p) {
+                float x = p.x - pivot.x, z = p.z - pivot.z;
+                p.x = pivot.x + c * x + s * z;
+                p.z = pivot.z - s * x + c * z;
+            };
+
+            const int n = static_cast<int>(triangles.size());
+            #pragma omp parallel for schedule(static) if (n >= 4096)
+            for (int i = 0; i < n; i++) {
+                Triangle& tri = triangles[i];
+                if (tri.object_id != spin.object_id) continue;
+                rotate(tri.v0);
+                rotate(tri.v1);
+                rotate(tri.v2);
+                tri.normal = Vec3::cross(tri.v1 - tri.v0, tri.v2 - tri.v0).normalized();
+            }
+        }
+        return true;
+    }
+
+private:
+    std::vector<Triangle> rest_;
+    MeshTransform transform_;
+
+    // Centro da caixa do objeto na pose do quadro 0
+    bool object_center(int object_id, Point3& center) const {
+        Point3 lo(1e30f, 1e30f, 1e30f), hi(-1e30f, -1e30f, -1e30f);
+        bool found = false;
+        for (const auto& tri : rest_) {
+            if (tri.object_id != object_id) continue;
+            found = true;
+            for (const auto& v : {tri.v0, tri.v1, tri.v2}) {
+                lo = Point3(std::min(lo.x, v.x), std::min(lo.y, v.y), std::min(lo.z, v.z));
+                hi = Point3(std::max(hi.x, v.x), std::max(hi.y, v.y), std::max(hi.z, v.z));
+            }
+        }
+        center = (lo + hi) * 0.5f;
+        return found;
+    }
+};
+
+#endif
@@ -0,0 +1,145 @@
+#ifndef ASYNC_WRITER_H
+#define ASYNC_WRITER_H
+
+#include <deque>
+#include <mutex>
+#include <vector>
+#include <thread>
+#include <utility>
+#include <functional>
+#include <condition_variable>
+#include <omp.h>
+#include "vec3.h"
+
+// Saída assíncrona: uma thread dedicada recebe buffers float prontos e faz
+// tonemap, codificação e gravação enquanto as threads de renderização já
+// trabalham no próximo quadro.
+//
+// A fila é limitada: com 'max_pending' buffers esperando, submit() bloqueia
+// (a renderização não pode acumular quadros sem limite na memória). Os
+// buffers gravados voltam para um pool e são reaproveitados por acquire().
+//
+// A sobreposição só vale quando há renderização em andamento (animação,
+// várias vistas): fora dela, submit() executa a tarefa na thread que chama,
+// com todas as threads do OpenMP, em vez de deixar os núcleos parados
+// esperando uma thread de gravação com poucas threads.
+
+class AsyncWriter {
+public:
+    using Task = std::function<void(const std::vector<Color>&)>;
+
+    // 'encode_threads' = threads OpenMP da thread de gravação (tonemap e PNG
+    // paralelos); 1 deixa os outros núcleos para a renderização sobreposta
+    explicit AsyncWriter(size_t max_pending = 4, int encode_threads = 1)
+        : max_pending_(max_pending > 0 ? max_pending : 1),
+          thread_([this, encode_threads] { run(encode_threads); }) {}
+
+    ~AsyncWriter() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stopping_ = true;
+        }
+        changed_.notify_all();
+        thread_.join();
+    }
+
+    AsyncWriter(const AsyncWriter&) = delete;
+    AsyncWriter& operator=(const AsyncWriter&) = delete;
+
+    // Buffer com 'n' elementos (conteúdo indefinido), do pool se houver um
+    // com capacidade suficiente
+    std::vector<Color> acquire(size_t n) {
+        std::vector<Color> buffer;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            for (size_t i = 0; i < pool_.size(); i++) {
+                if (pool_[i].capacity() >= n) {
+                    buffer = std::move(pool_[i]);
+                    pool_.erase(pool_.begin() + i);
+                    reused_++;
+                    break;
+                }
+            }
+        }
+        buffer.resize(n);
+        return buffer;
+    }
+
+    // Liga ou desliga a gravação em segundo plano (padrão: desligada)
+    void set_overlap(bool overlap) {
+        flush();
+        std::lock_guard<std::mutex> lock(mutex_);
+        overlap_ = overlap;
+    }
+
+    // Enfileira 'task(buffer)' para a thread de gravação (bloqueia se a fila
+    // estiver cheia) ou, sem sobreposição, executa aqui. O buffer volta para
+    // o pool depois da tarefa.
+    void submit(std::vector<Color>&& buffer, Task task) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        if (!overlap_) {
+            lock.unlock();
+            task(buffer);
+            lock.lock();
+            if (pool_.size() < max_pending_ + 2) pool_.push_back(std::move(buffer));
+            return;
+        }
+        changed_.wait(lock, [this] { return queue_.size() < max_pending_; });
+        queue_.push_back({std::move(buffer), std::move(task)});
+        changed_.notify_all();
+    }
+
+    // Espera todas as tarefas enfileiradas terminarem
+    void flush() {
+        std::unique_lock<std::mutex> lock(mutex_);
+        changed_.wait(lock, [this] { return queue_.empty() && !busy_; });
+    }
+
+    // Buffers reaproveitados do pool até agora
+    size_t reused() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return reused_;
+    }
+
+private:
+    struct Item {
+        std::vector<Color> buffer;
+        Task task;
+    };
+
+    void run(int encode_threads) {
+        omp_set_num_threads(encode_threads > 0 ? encode_threads : 1);
+        std::unique_lock<std::mutex> lock(mutex_);
+        while (true) {
+            changed_.wait(lock, [this] { return stopping_ || !queue_.empty(); });
+            if (queue_.empty()) return; // Parando e sem nada pendente
+
+            Item item = std::move(queue_.front());
+            queue_.pop_front();
+            busy_ = true;
+            changed_.notify_all(); // Libera um submit() bloqueado
+
+            lock.unlock();
+            item.task(item.buffer);
+            lock.lock();
+
+            // Guarda no máximo 'max_pending' + 2 buffers livres
+            if (pool_.size() < max_pending_ + 2) pool_.push_back(std::move(item.buffer));
+            busy_ = false;
+            changed_.notify_all();
+        }
+    }
+
+    size_t max_pending_;
+    mutable std::mutex mutex_;
+    std::condition_variable changed_;
+    std::deque<Item> queue_;
+    std::vector<std::vector<Color>> pool_;
+    size_t reused_ = 0;
+    bool busy_ = false;
+    bool stopping_ = false;
+    bool overlap_ = false;
+    std::thread thread_; // Por último: começa depois dos outros membros
+};
+
+#endif
@@ -0,0 +1,304 @@
+#ifndef BVH_H
+#define BVH_H
+
+#include <vector>
+#include <algorithm>
+#include "vec3.h"
+#include "ray.h"
+#include "obj_loader.h"
+#include "triangle_block.h"
+
+// BVH dos triângulos com folhas de até 8 triângulos: cada folha é um
+// TriangleBlock8, testado de uma vez com AVX2.
+//
+// build() divide pelo SAH com 16 intervalos (binned). Quando só as posições
+// dos vértices mudam (quadros de uma animação), refit() recalcula os blocos e
+// as caixas sem mexer na topologia da árvore: as folhas em paralelo e depois
+// os nós internos nível por nível, do mais fundo para a raiz. A qualidade da
+// árvore cai conforme os triângulos se afastam das posições do build; o
+// custo das caixas relativo ao do último build (quality()) diz quando reconstruir.
+
+struct BVHNode {
+    Point3 lo, hi;      // Caixa envolvente
+    int child = -1;     // Interno: filhos em 'child' e 'child' + 1 (-1 = folha)
+    int axis = 0;       // Eixo da divisão (ordem de visita dos filhos)
+    int first = 0;      // Folha: triângulos order[first, first + count)
+    int count = 0;
+    int block = -1;     // Folha: bloco SIMD com os mesmos triângulos
+
+    bool is_leaf() const { return child < 0; }
+};
+
+class TriangleBVH {
+public:
+    static constexpr int LEAF_SIZE = 8;
+    static constexpr int BINS = 16;
+    static constexpr int MAX_SAH_DEPTH = 40; // Abaixo disso, só mediana (limita a pilha da travessia)
+    static constexpr int LINEAR_LEAVES = 4;  // Até aqui as folhas são testadas todas, sem as caixas
+
+    std::vector<BVHNode> nodes;     // Raiz em nodes[0]
+    std::vector<int> order;         // Índices dos triângulos, agrupados por folha
+
+    bool empty() const { return nodes.empty(); }
+    size_t primitive_count() const { return order.size(); }
+
+    // Cena pequena (a Cornell Box tem 4 blocos): as caixas das paredes cobrem
+    // a sala inteira e testá-las só custaria tempo; melhor testar todas as folhas
+    bool linear() const { return leaves_.size() <= LINEAR_LEAVES; }
+
+    // Constrói a árvore e os blocos SIMD das folhas ('blocks' é substituído)
+    void build(const std::vector<Triangle>& triangles, std::vector<TriangleBlock8>& blocks) {
+        nodes.clear();
+        order.resize(triangles.size());
+        leaves_.clear();
+        levels_.clear();
+        blocks.clear();
+        if (triangles.empty()) {
+            build_cost_ = 0.0f;
+            return;
+        }
+
+        std::vector<Point3> centroids(triangles.size());
+        for (size_t i = 0; i < triangles.size(); i++) {
+            order[i] = static_cast<int>(i);
+            centroids[i] = (triangles[i].v0 + triangles[i].v1 + triangles[i].v2) * (1.0f / 3.0f);
+        }
+
+        nodes.reserve(2 * (triangles.size() / LEAF_SIZE + 1));
+        nodes.emplace_back();
+        split(0, 0, static_cast<int>(triangles.size()), 0, triangles, centroids);
+
+        blocks.resize(leaves_.size());
+        for (size_t l = 0; l < leaves_.size(); l++) nodes[leaves_[l]].block = static_cast<int>(l);
+        refit_leaves(triangles, blocks);
+        refit_nodes();
+        build_cost_ = node_cost();
+    }
+
+    // Atualiza blocos e caixas para as novas posições dos triângulos (mesmo
+    // número de triângulos do build). Retorna quality().
+    float refit(const std::vector<Triangle>& triangles, std::vector<TriangleBlock8>& blocks) {
+        if (nodes.empty()) return 1.0f;
+        refit_leaves(triangles, blocks);
+        refit_nodes();
+        return quality();
+    }
+
+    // Custo das caixas agora dividido pelo custo logo após o último build
+    // (não o de uma árvore nova para as posições atuais, que exigiria
+    // construí-la). É a soma das áreas, sem dividir pela raiz: se a cena
+    // inteira cresce ou encolhe (um objeto girando muda a caixa da raiz), a
+    // razão acompanha as caixas infladas pelo refit em vez de cair abaixo de 1.
+    // 1 = caixas do mesmo tamanho do build; 1.5 = raios testam ~50% mais área.
+    float quality() const {
+        return build_cost_ > 0.0f ? node_cost() / build_cost_ : 1.0f;
+    }
+
+    // Custo SAH esperado de um raio: áreas relativas à raiz, teste de caixa = 1,
+    // interseção de um bloco de 8 = 1 (um teste SIMD)
+    float sah_cost() const {
+        if (nodes.empty()) return 0.0f;
+        float root = area(nodes[0]);
+        if (root <= 0.0f) return 0.0f;
+        float cost = 0.0f;
+        for (const auto& node : nodes) cost += area(node) * (node.is_leaf() ? 2.0f : 1.0f);
+        return cost / root;
+    }
+
+    // Caixa atingida em [t_min, t_max]? ('inv_dir' = 1 / direção)
+    static bool hit_box(const BVHNode& node, const Point3& orig, const Vec3& inv_dir, float t_min, float t_max) {
+        float t0 = (node.lo.x - orig.x) * inv_dir.x, t1 = (node.hi.x - orig.x) * inv_dir.x;
+        t_min = std::max(t_min, std::min(t0, t1));
+        t_max = std::min(t_max, std::max(t0, t1));
+        t0 = (node.lo.y - orig.y) * inv_dir.y; t1 = (node.hi.y - orig.y) * inv_dir.y;
+        t_min = std::max(t_min, std::min(t0, t1));
+        t_max = std::min(t_max, std::max(t0, t1));
+        t0 = (node.lo.z - orig.z) * inv_dir.z; t1 = (node.hi.z - orig.z) * inv_dir.z;
+        t_min = std::max(t_min, std::min(t0, t1));
+        t_max = std::min(t_max, std::max(t0, t1));
+        return t_min <= t_max;
+    }
+
+    // Percorre as folhas atingidas pelo raio, da mais próxima para a mais
+    // distante na ordem dos eixos de divisão. 'visit(node)' recebe a folha e
+    // devolve o novo t_max (a distância do acerto mais próximo até agora).
+    template <typename Visit>
+    void traverse(const Ray& r, float t_min, float t_max, Visit visit) const {
+        if (nodes.empty()) return;
+        if (linear()) {
+            for (int leaf : leaves_) t_max = visit(nodes[leaf]);
+            return;
+        }
+        Vec3 inv_dir(1.0f / r.direction.x, 1.0f / r.direction.y, 1.0f / r.direction.z);
+        const bool negative[3] = {inv_dir.x < 0.0f, inv_dir.y < 0.0f, inv_dir.z < 0.0f};
+
+        int stack[64];
+        int top = 0;
+        stack[top++] = 0;
+        while (top > 0) {
+            const BVHNode& node = nodes[stack[--top]];
+            if (!hit_box(node, r.origin, inv_dir, t_min, t_max)) continue;
+            if (node.is_leaf()) {
+                t_max = visit(node);
+                continue;
+            }
+            // Empilha o filho distante primeiro
+            int near = node.child + (negative[node.axis] ? 1 : 0);
+            stack[top++] = near == node.child ? node.child + 1 : node.child;
+            stack[top++] = near;
+        }
+    }
+
+private:
+    std::vector<int> leaves_;               // Nós folha
+    std::vector<std::vector<int>> levels_;  // Nós internos por profundidade
+    float build_cost_ = 0.0f;
+
+    // Soma das áreas dos nós (folhas valem 2, como em sah_cost())
+    float node_cost() const {
+        float cost = 0.0f;
+        for (const auto& node : nodes) cost += area(node) * (node.is_leaf() ? 2.0f : 1.0f);
+        return cost;
+    }
+
+    static float area(const BVHNode& node) {
+        Vec3 d = node.hi - node.lo;
+        return 2.0f * (d.x * d.y + d.y * d.z + d.z * d.x);
+    }
+
+    static void grow(Point3& lo, Point3& hi, const Point3& p) {
+        lo = Point3(std::min(lo.x, p.x), std::min(lo.y, p.y), std::min(lo.z, p.z));
+        hi = Point3(std::max(hi.x, p.x), std::max(hi.y, p.y), std::max(hi.z, p.z));
+    }
+
+    // Divide order[first, first + count) no nó 'index' (recursivo)
+    void split(int index, int first, int count, int depth, const std::vector<Triangle>& triangles,
+               const std::vector<Point3>& centroids) {
+        nodes[index].first = first;
+        nodes[index].count = count;
+        if (count <= LEAF_SIZE) {
+            leaves_.push_back(index);
+            return;
+        }
+
+        // Caixa dos centróides: eixo e intervalos da divisão
+        Point3 lo(1e30f, 1e30f, 1e30f), hi(-1e30f, -1e30f, -1e30f);
+        for (int i = first; i < first + count; i++) grow(lo, hi, centroids[order[i]]);
+        Vec3 extent = hi - lo;
+        int axis = extent.x > extent.y ? (extent.x > extent.z ? 0 : 2) : (extent.y > extent.z ? 1 : 2);
+        auto coord = [axis](const Point3& p) { return axis == 0 ? p.x : axis == 1 ? p.y : p.z; };
+        float axis_lo = coord(lo), axis_extent = coord(extent);
+
+        int mid = first + count / 2;
+        bool split_found = false;
+        if (axis_extent > 0.0f && depth < MAX_SAH_DEPTH) {
+            // Intervalos: número de triângulos e caixa de cada um
+            struct Bin { Point3 lo{1e30f, 1e30f, 1e30f}, hi{-1e30f, -1e30f, -1e30f}; int count = 0; };
+            Bin bins[BINS];
+            auto bin_of = [&](int tri) {
+                int b = static_cast<int>((coord(centroids[tri]) - axis_lo) / axis_extent * BINS);
+                return std::min(b, BINS - 1);
+            };
+            for (int i = first; i < first + count; i++) {
+                const Triangle& tri = triangles[order[i]];
+                Bin& bin = bins[bin_of(order[i])];
+                bin.count++;
+                grow(bin.lo, bin.hi, tri.v0);
+                grow(bin.lo, bin.hi, tri.v1);
+                grow(bin.lo, bin.hi, tri.v2);
+            }
+
+            // Custo de cada plano entre intervalos (área x blocos de 8)
+            auto box_area = [](const Point3& a, const Point3& b) {
+                Vec3 d = b - a;
+                return d.x < 0.0f ? 0.0f : 2.0f * (d.x * d.y + d.y * d.z + d.z * d.x);
+            };
+            float left_cost[BINS - 1];
+            Point3 l_lo(1e30f, 1e30f, 1e30f), l_hi(-1e30f, -1e30f, -1e30f);
+            int l_count = 0;
+            for (int b = 0; b < BINS - 1; b++) {
+                grow(l_lo, l_hi, bins[b].lo);
+                grow(l_lo, l_hi, bins[b].hi);
+                l_count += bins[b].count;
+                left_cost[b] = box_area(l_lo, l_hi) * ((l_count + LEAF_SIZE - 1) / LEAF_SIZE);
+            }
+            Point3 r_lo(1e30f, 1e30f, 1e30f), r_hi(-1e30f, -1e30f, -1e30f);
+            int r_count = 0, best = -1;
+            float best_cost = 1e30f;
+            for (int b = BINS - 1; b > 0; b--) {
+                grow(r_lo, r_hi, bins[b].lo);
+                grow(r_lo, r_hi, bins[b].hi);
+                r_count += bins[b].count;
+                if (r_count == 0 || r_count == count) continue;
+                float cost = left_cost[b - 1] + box_area(r_lo, r_hi) * ((r_count + LEAF_SIZE - 1) / LEAF_SIZE);
+                if (cost < best_cost) {
+                    best_cost = cost;
+                    best = b;
+                }
+            }
+            if (best > 0) {
+                split_found = true;
+                mid = static_cast<int>(std::partition(order.begin() + first, order.begin() + first + count,
+                                                      [&](int tri) { return bin_of(tri) < best; }) - order.begin());
+            }
+        }
+        if (!split_found) {
+            // Centróides coincidentes ou nenhum plano útil: divide pela mediana
+            std::nth_element(order.begin() + first, order.begin() + mid, order.begin() + first + count,
+                             [&](int a, int b) { return coord(centroids[a]) < coord(centroids[b]); });
+        }
+
+        int child = static_cast<int>(nodes.size());
+        nodes.emplace_back();
+        nodes.emplace_back();
+        nodes[index].child = child;
+        nodes[index].axis = axis;
+        if (static_cast<int>(levels_.size()) <= depth) levels_.resize(depth + 1);
+        levels_[depth].push_back(index);
+
+        split(child, first, mid - first, depth + 1, triangles, centroids);
+        split(child + 1, mid, first + count - mid, depth + 1, triangles, centroids);
+    }
+
+    // Caixas dos nós internos, um nível por vez (os nós de um nível em paralelo)
+    void refit_nodes() {
+        for (int d = static_cast<int>(levels_.size()) - 1; d >= 0; d--) {
+            const std::vector<int>& level = levels_[d];
+            const int n = static_cast<int>(level.size());
+            #pragma omp parallel for schedule(static) if (n >= 256)
+            for (int k = 0; k < n; k++) {
+                BVHNode& node = nodes[level[k]];
+                const BVHNode& a = nodes[node.child];
+                const BVHNode& b = nodes[node.child + 1];
+                node.lo = Point3(std::min(a.lo.x, b.lo.x), std::min(a.lo.y, b.lo.y), std::min(a.lo.z, b.lo.z));
+                node.hi = Point3(std::max(a.hi.x, b.hi.x), std::max(a.hi.y, b.hi.y), std::max(a.hi.z, b.hi.z));
+            }
+        }
+    }
+
+    // Blocos e caixas das folhas, em paralelo
+    void refit_leaves(const std::vector<Triangle>& triangles, std::vector<TriangleBlock8>& blocks) {
+        const int n = static_cast<int>(leaves_.size());
+        #pragma omp parallel for schedule(static) if (n >= 64)
+        for (int l = 0; l < n; l++) {
+            BVHNode& node = nodes[leaves_[l]];
+            TriangleBlock8& block = blocks[node.block];
+            node.lo = Point3(1e30f, 1e30f, 1e30f);
+            node.hi = Point3(-1e30f, -1e30f, -1e30f);
+            for (int lane = 0; lane < LEAF_SIZE; lane++) {
+                if (lane >= node.count) {
+                    block.set_lane(lane, nullptr, -1);
+                    continue;
+                }
+                int i = order[node.first + lane];
+                const Triangle& tri = triangles[i];
+                block.set_lane(lane, &tri, i);
+                grow(node.lo, node.hi, tri.v0);
+                grow(node.lo, node.hi, tri.v1);
+                grow(node.lo, node.hi, tri.v2);
+            }
+        }
+    }
+};
+
+#endif
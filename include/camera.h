@@ -0,0 +1,56 @@
+#ifndef CAMERA_H
+#define CAMERA_H
+
+#include <cmath>
+#include "vec3.h"
+#include "ray.h"
+#include "simd.h"
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+// Câmera pinhole
+struct Camera {
+    Point3 position;
+    Vec3 forward, right, up;
+    float scale;        // tan(fov/2)
+    float aspect;
+    int width, height;
+
+    Camera(Point3 pos, Point3 target, float fov_degrees, int width, int height)
+        : position(pos), width(width), height(height) {
+        forward = (target - pos).normalized();
+        Vec3 world_up(0, 1, 0);
+        right = Vec3::cross(forward, world_up).normalized();
+        up = Vec3::cross(right, forward).normalized();
+
+        float fov = fov_degrees * M_PI / 180.0f;
+        scale = std::tan(fov * 0.5f);
+        aspect = static_cast<float>(width) / height;
+    }
+
+    // Direção (não normalizada) pela posição contínua (px, py) em pixels
+    Vec3 direction_raw(float px, float py) const {
+        float u = (px / width - 0.5f) * 2.0f;
+        float v = (py / height - 0.5f) * 2.0f;
+        return forward + right * (u * scale * aspect) + up * (v * scale);
+    }
+
+    // Raio pela posição (px, py). Com 'differential_scale' > 0, anexa os
+    // diferenciais para vizinhos a essa distância (em pixels). As direções
+    // diferenciais não precisam ser normalizadas.
+    Ray get_ray(float px, float py, float differential_scale = 0.0f) const {
+        Ray r(position, normalize_fast(direction_raw(px, py)));
+        if (differential_scale > 0.0f) {
+            r.has_differentials = true;
+            r.rx_origin = position;
+            r.ry_origin = position;
+            r.rx_direction = direction_raw(px + differential_scale, py);
+            r.ry_direction = direction_raw(px, py + differential_scale);
+        }
+        return r;
+    }
+};
+
+#endif
@@ -0,0 +1,289 @@
+#ifndef CHECKPOINT_H
+#define CHECKPOINT_H
+
+#include <cstdio>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <filesystem>
+#include <iostream>
+#include <algorithm>
+#include "vec3.h"
+#include "scene.h"
+#include "timeline.h"
+
+// Checkpoint do buffer de acumulação: somas de radiância e número de
+// amostras por pixel, mais o estado do amostrador (semente + passadas
+// concluídas) e um hash da cena para não misturar renderizações diferentes.
+// O buffer pode cobrir só uma janela da imagem (um bloco de um shard
+// distribuído); as linhas da janela seguem a ordem do framebuffer (0 = topo).
+//
+// Formato (little-endian):
+//   "PTCK" | versão u32 | largura i32 | altura i32 | hash u64 | semente u64 |
+//   primeira passada u32 | passadas u32 | amostras por passada u32 |
+//   janela x0 y0 w h i32[4] | somas float[3*w*h] | contagens u32[w*h] |
+//   AOVs: albedo float[3*w*h] | normal float[3*w*h] | profundidade float[w*h] |
+//   luminância² float[w*h]
+
+// Hash FNV-1a incremental
+struct Hasher {
+    uint64_t value = 14695981039346656037ULL;
+
+    void bytes(const void* data, size_t size) {
+        const unsigned char* p = static_cast<const unsigned char*>(data);
+        for (size_t i = 0; i < size; i++) {
+            value ^= p[i];
+            value *= 1099511628211ULL;
+        }
+    }
+
+    template <typename T>
+    void add(const T& v) { bytes(&v, sizeof(T)); }
+
+    void add(const Vec3& v) { add(v.x); add(v.y); add(v.z); }
+};
+
+// Hash da geometria e dos materiais da cena
+inline uint64_t scene_hash(const Scene& scene) {
+    Hasher h;
+    for (const auto& tri : scene.triangles) {
+        h.add(tri.v0); h.add(tri.v1); h.add(tri.v2);
+        h.add(tri.albedo); h.add(tri.emission);
+        h.add(static_cast<int>(tri.mat_type)); h.add(tri.fuzz);
+    }
+    for (const auto& s : scene.spheres) {
+        h.add(s.center); h.add(s.radius);
+        h.add(s.albedo); h.add(s.emission);
+        h.add(static_cast<int>(s.mat_type)); h.add(s.fuzz);
+    }
+    for (const auto& p : scene.planes) {
+        h.add(p.point); h.add(p.normal);
+        h.add(p.albedo); h.add(p.emission);
+    }
+    h.add(static_cast<int>(scene.texture_type));
+    if (scene.environment.loaded()) {
+        h.add(scene.environment.width()); h.add(scene.environment.height()); h.add(scene.environment.rotation());
+        h.bytes(scene.environment.texels().data(), scene.environment.texels().size() * sizeof(Color));
+    }
+    return h.value;
+}
+
+struct Checkpoint {
+    static constexpr uint32_t VERSION = 3;
+
+    int width = 0, height = 0;      // Imagem inteira
+    uint64_t scene_hash = 0;
+    uint64_t seed = 0;
+    uint32_t first_pass = 0;        // Passadas [first_pass, passes_done)
+    uint32_t passes_done = 0;
+    uint32_t pass_spp = 0;
+    int window_x = 0, window_y = 0; // Janela coberta pelo buffer
+    int window_w = 0, window_h = 0;
+    std::vector<Color> accum;       // Soma (não normalizada) das amostras
+    std::vector<uint32_t> counts;   // Amostras acumuladas em cada pixel
+
+    // Somas das AOVs do primeiro acerto (para o denoiser)
+    std::vector<Color> albedo;
+    std::vector<Vec3> normal;
+    std::vector<float> depth;
+    std::vector<float> lum_sq;      // Soma da luminância² das amostras
+
+    // Buffer da imagem inteira
+    void init(int w, int h, uint64_t hash, uint64_t s, uint32_t spp_per_pass) {
+        init_window(w, h, hash, s, spp_per_pass, 0, 0, w, h);
+    }
+
+    // Buffer só da janela [x0, x0 + w) x [y0, y0 + h)
+    void init_window(int w, int h, uint64_t hash, uint64_t s, uint32_t spp_per_pass,
+                     int x0, int y0, int win_w, int win_h) {
+        width = w;
+        height = h;
+        scene_hash = hash;
+        seed = s;
+        first_pass = 0;
+        passes_done = 0;
+        pass_spp = spp_per_pass;
+        window_x = x0;
+        window_y = y0;
+        window_w = win_w;
+        window_h = win_h;
+        size_t n = static_cast<size_t>(win_w) * win_h;
+        accum.assign(n, Color(0, 0, 0));
+        counts.assign(n, 0);
+        albedo.assign(n, Color(0, 0, 0));
+        normal.assign(n, Vec3(0, 0, 0));
+        depth.assign(n, 0.0f);
+        lum_sq.assign(n, 0.0f);
+    }
+
+    // Descarta os buffers e mantém só os metadados
+    void release_buffers() {
+        accum = {};
+        counts = {};
+        albedo = {};
+        normal = {};
+        depth = {};
+        lum_sq = {};
+    }
+
+    // Índice no buffer do pixel (x, y) da imagem (deve estar na janela)
+    size_t index(int x, int y) const {
+        return static_cast<size_t>(y - window_y) * window_w + (x - window_x);
+    }
+
+    // Média por pixel da imagem inteira (pixels sem amostras ficam pretos)
+    std::vector<Color> resolve() const {
+        std::vector<Color> image;
+        resolve(image);
+        return image;
+    }
+
+    // O mesmo, reaproveitando o buffer 'image'
+    void resolve(std::vector<Color>& image) const {
+        image.assign(static_cast<size_t>(width) * height, Color(0, 0, 0));
+        for (int y = 0; y < window_h; y++) {
+            for (int x = 0; x < window_w; x++) {
+                size_t i = static_cast<size_t>(y) * window_w + x;
+                if (counts[i]) {
+                    image[static_cast<size_t>(window_y + y) * width + window_x + x] =
+                        accum[i] / static_cast<float>(counts[i]);
+                }
+            }
+        }
+    }
+
+    // Médias das AOVs na imagem inteira e a variância da média da luminância
+    // de cada pixel (estimada pelas amostras)
+    void resolve_aovs(std::vector<Color>& albedo_out, std::vector<Vec3>& normal_out,
+                      std::vector<float>& depth_out, std::vector<float>& variance_out) const {
+        size_t n = static_cast<size_t>(width) * height;
+        albedo_out.assign(n, Color(0, 0, 0));
+        normal_out.assign(n, Vec3(0, 0, 0));
+        depth_out.assign(n, 0.0f);
+        variance_out.assign(n, 0.0f);
+        for (int y = 0; y < window_h; y++) {
+            for (int x = 0; x < window_w; x++) {
+                size_t i = static_cast<size_t>(y) * window_w + x;
+                if (!counts[i]) continue;
+                size_t o = static_cast<size_t>(window_y + y) * width + window_x + x;
+                float inv = 1.0f / counts[i];
+                albedo_out[o] = albedo[i] * inv;
+                normal_out[o] = normal[i].normalized();
+                depth_out[o] = depth[i] * inv;
+                float mean = luminance(accum[i]) * inv;
+                variance_out[o] = std::max(0.0f, lum_sq[i] * inv - mean * mean) * inv;
+            }
+        }
+    }
+
+    // Gravação atômica: escreve num arquivo temporário e renomeia por cima,
+    // de modo que um processo morto no meio nunca deixa um checkpoint truncado
+    bool save(const std::string& path) const {
+        PT_TIMELINE_SCOPE("Checkpoint::save", "checkpoint");
+        std::string tmp = path + ".tmp";
+        FILE* f = std::fopen(tmp.c_str(), "wb");
+        if (!f) return false;
+
+        bool ok = std::fwrite("PTCK", 1, 4, f) == 4;
+        ok = ok && write_value(f, VERSION);
+        ok = ok && write_value(f, width) && write_value(f, height);
+        ok = ok && write_value(f, scene_hash) && write_value(f, seed);
+        ok = ok && write_value(f, first_pass) && write_value(f, passes_done) && write_value(f, pass_spp);
+        ok = ok && write_value(f, window_x) && write_value(f, window_y);
+        ok = ok && write_value(f, window_w) && write_value(f, window_h);
+        ok = ok && std::fwrite(accum.data(), sizeof(Color), accum.size(), f) == accum.size();
+        ok = ok && std::fwrite(counts.data(), sizeof(uint32_t), counts.size(), f) == counts.size();
+        ok = ok && std::fwrite(albedo.data(), sizeof(Color), albedo.size(), f) == albedo.size();
+        ok = ok && std::fwrite(normal.data(), sizeof(Vec3), normal.size(), f) == normal.size();
+        ok = ok && std::fwrite(depth.data(), sizeof(float), depth.size(), f) == depth.size();
+        ok = ok && std::fwrite(lum_sq.data(), sizeof(float), lum_sq.size(), f) == lum_sq.size();
+        ok = (std::fflush(f) == 0) && ok;
+        ok = (std::fclose(f) == 0) && ok;
+
+        std::error_code ec;
+        if (ok) std::filesystem::rename(tmp, path, ec);
+        if (!ok || ec) {
+            std::filesystem::remove(tmp, ec);
+            return false;
+        }
+        return true;
+    }
+
+    bool load(const std::string& path) {
+        FILE* f = std::fopen(path.c_str(), "rb");
+        if (!f) return false;
+
+        char magic[4];
+        uint32_t version = 0;
+        bool ok = std::fread(magic, 1, 4, f) == 4 && std::memcmp(magic, "PTCK", 4) == 0;
+        ok = ok && read_value(f, version) && version == VERSION;
+        ok = ok && read_value(f, width) && read_value(f, height) && width > 0 && height > 0;
+        ok = ok && read_value(f, scene_hash) && read_value(f, seed);
+        ok = ok && read_value(f, first_pass) && read_value(f, passes_done) && read_value(f, pass_spp);
+        ok = ok && read_value(f, window_x) && read_value(f, window_y);
+        ok = ok && read_value(f, window_w) && read_value(f, window_h);
+        ok = ok && window_x >= 0 && window_y >= 0 && window_w >= 0 && window_h >= 0 &&
+             window_x + window_w <= width && window_y + window_h <= height;
+        if (ok) {
+            size_t n = static_cast<size_t>(window_w) * window_h;
+            accum.resize(n);
+            counts.resize(n);
+            albedo.resize(n);
+            normal.resize(n);
+            depth.resize(n);
+            lum_sq.resize(n);
+            ok = std::fread(accum.data(), sizeof(Color), n, f) == n &&
+                 std::fread(counts.data(), sizeof(uint32_t), n, f) == n &&
+                 std::fread(albedo.data(), sizeof(Color), n, f) == n &&
+                 std::fread(normal.data(), sizeof(Vec3), n, f) == n &&
+                 std::fread(depth.data(), sizeof(float), n, f) == n &&
+                 std::fread(lum_sq.data(), sizeof(float), n, f) == n;
+        }
+        std::fclose(f);
+        return ok;
+    }
+
+    // Soma as amostras de outro checkpoint da mesma cena (outra semente,
+    // outras passadas ou outra região da imagem). A janela de 'other' precisa
+    // estar dentro da deste buffer. Retorna false se forem incompatíveis.
+    bool merge(const Checkpoint& other) {
+        if (other.width != width || other.height != height || other.scene_hash != scene_hash ||
+            other.window_x < window_x || other.window_y < window_y ||
+            other.window_x + other.window_w > window_x + window_w ||
+            other.window_y + other.window_h > window_y + window_h) {
+            return false;
+        }
+        for (int y = 0; y < other.window_h; y++) {
+            size_t src = static_cast<size_t>(y) * other.window_w;
+            size_t dst = index(other.window_x, other.window_y + y);
+            for (int x = 0; x < other.window_w; x++) {
+                accum[dst + x] = accum[dst + x] + other.accum[src + x];
+                counts[dst + x] += other.counts[src + x];
+                albedo[dst + x] = albedo[dst + x] + other.albedo[src + x];
+                normal[dst + x] = normal[dst + x] + other.normal[src + x];
+                depth[dst + x] += other.depth[src + x];
+                lum_sq[dst + x] += other.lum_sq[src + x];
+            }
+        }
+        return true;
+    }
+
+    // Mesma semente e passadas em comum: as amostras se repetem nos pixels
+    // que os dois buffers cobrem
+    bool overlaps(const Checkpoint& other) const {
+        return other.seed == seed &&
+               other.first_pass < passes_done && first_pass < other.passes_done &&
+               other.window_x < window_x + window_w && window_x < other.window_x + other.window_w &&
+               other.window_y < window_y + window_h && window_y < other.window_y + other.window_h;
+    }
+
+private:
+    template <typename T>
+    static bool write_value(FILE* f, const T& v) { return std::fwrite(&v, sizeof(T), 1, f) == 1; }
+
+    template <typename T>
+    static bool read_value(FILE* f, T& v) { return std::fread(&v, sizeof(T), 1, f) == 1; }
+};
+
+#endif
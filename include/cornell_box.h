@@ -0,0 +1,116 @@
+#ifndef CORNELL_BOX_H
+#define CORNELL_BOX_H
+
+#include <string>
+#include <vector>
+#include <iostream>
+#include "vec3.h"
+#include "sphere.h"
+#include "obj_loader.h"
+#include "scene.h"
+#include "timeline.h"
+
+// Transformação do OBJ para a cena: altura 2, chão em y = 0, centrada em
+// x/z e girada 180 graus em torno de Y
+struct MeshTransform {
+    float center_x = 0.0f, center_y = 0.0f, center_z = 0.0f;
+    float scale = 1.0f;
+    
+    // Ajusta a transformação à caixa envolvente da malha
+    static MeshTransform fit(const std::vector<Triangle>& mesh) {
+        // Encontra os limites (Bounding Box)
+        float min_x = 1e9, max_x = -1e9;
+        float min_y = 1e9, max_y = -1e9;
+        float min_z = 1e9, max_z = -1e9;
+
+        for (const auto& tri : mesh) {
+            for (const auto& v : {tri.v0, tri.v1, tri.v2}) {
+                if (v.x < min_x) min_x = v.x; if (v.x > max_x) max_x = v.x;
+                if (v.y < min_y) min_y = v.y; if (v.y > max_y) max_y = v.y;
+                if (v.z < min_z) min_z = v.z; if (v.z > max_z) max_z = v.z;
+            }
+        }
+
+        // Calcula o centro e a escala
+        MeshTransform xf;
+        xf.center_x = (min_x + max_x) / 2.0f;
+        xf.center_y = min_y; // Base no 0
+        xf.center_z = (min_z + max_z) / 2.0f;
+        
+        // A sala tem ~555 de altura. Queremos altura ~2.0 na cena.
+        float max_dim = max_y - min_y; 
+        xf.scale = 2.0f / max_dim; 
+        return xf;
+    }
+    
+    // Aplica em todos os triângulos e recalcula as normais
+    void apply(std::vector<Triangle>& mesh) const {
+        for (auto& tri : mesh) {
+            auto transform = [&](Point3& p) {
+                p.x = (p.x - center_x) * scale;
+                p.y = (p.y - center_y) * scale;
+                p.z = (p.z - center_z) * scale;
+                
+                // Opcional: Girar 180 graus se a sala estiver de costas
+                // (A Cornell box original olha para +Z, nossa câmera olha para -Z ou vice versa)
+                // Experimente descomentar se vir tudo preto:
+                p.x = -p.x; 
+                p.z = -p.z; 
+            };
+            
+            transform(tri.v0);
+            transform(tri.v1);
+            transform(tri.v2);
+            
+            // Recalcula normal
+            Vec3 e1 = tri.v1 - tri.v0;
+            Vec3 e2 = tri.v2 - tri.v0;
+            tri.normal = Vec3::cross(e1, e2).normalized();
+        }
+    }
+};
+
+// Cornell Box do OBJ (com a luz de área 'usemtl light'), normalizada para
+// altura 2 com o chão em y = 0, mais a esfera metálica. Devolve a cena já com build() feito
+// (ou vazia se o arquivo não carregar). 'fitted' recebe a transformação
+// aplicada ao OBJ (para carregar outros quadros da mesma malha).
+inline Scene load_cornell_box(const std::string& obj_path = "scenes/cornell_box.obj",
+                              MeshTransform* fitted = nullptr) {
+    PT_TIMELINE_SCOPE("load_cornell_box", "cena");
+    Scene scene;
+    
+    // 1. Carrega O ARQUIVO DO PROFESSOR completo (paredes + caixas)
+    std::vector<Triangle> mesh;
+    {
+        PT_TIMELINE_SCOPE("OBJLoader::load", "cena");
+        mesh = OBJLoader::load(obj_path);
+    }
+    
+    if (mesh.empty()) {
+        std::cerr << "ERRO: Malha vazia! Verifique o caminho do arquivo." << std::endl;
+        return scene;
+    }
+
+    // 2. Lógica de Normalização (Auto-Scale)
+    // A Cornell Box original vai de 0 a 555. Queremos converter para -1 a 1 (tamanho 2).
+    timeline::Scope normalize_event("normalizar", "cena");
+    MeshTransform xf = MeshTransform::fit(mesh);
+    std::cout << "Escalando cena... Fator: " << xf.scale << std::endl;
+
+    // Aplica a transformação em todos os triângulos carregados
+    xf.apply(mesh);
+    scene.triangles = std::move(mesh);
+    if (fitted) *fitted = xf;
+
+    normalize_event.end();
+    
+    // 3. Objetos Extras (a luz é o quad 'usemtl light' do próprio OBJ)
+    // Esfera Metálica (Exemplo extra, já que o OBJ já tem as caixas)
+    // Posicionada levemente à frente
+    scene.spheres.push_back(Sphere(Point3(0.4f, 0.4f, -0.4f), 0.4f, Color(0.8f, 0.8f, 0.8f), METAL, 0.05f));
+
+    scene.build();
+    return scene;
+}
+
+#endif
@@ -0,0 +1,112 @@
+#ifndef COST_MAP_H
+#define COST_MAP_H
+
+#include <cmath>
+#include <string>
+#include <vector>
+#include <iostream>
+#include <algorithm>
+#include "vec3.h"
+#include "image_io.h"
+
+// Mapa de custo por pixel (depuração): tempo de parede e raios lançados em
+// cada pixel, somados sobre todas as passadas. Mostra as regiões caras da
+// imagem (a esfera de metal, os cantos com muitas inter-reflexões) e serve
+// para ajustar o tamanho dos blocos do escalonador.
+//
+// No integrador em lote os caminhos de uma linha são traçados juntos: o tempo
+// é medido por linha e repartido entre os pixels pelos raios de cada um (o
+// custo das texturas fica diluído). No integrador por pixel o tempo é exato.
+
+struct CostMap {
+    int width = 0, height = 0;
+    std::vector<float> seconds;     // Tempo gasto no pixel
+    std::vector<uint32_t> rays;     // Raios lançados (primários + secundários)
+    std::vector<uint32_t> samples;  // Amostras traçadas
+
+    void init(int w, int h) {
+        width = w;
+        height = h;
+        size_t n = static_cast<size_t>(w) * h;
+        seconds.assign(n, 0.0f);
+        rays.assign(n, 0);
+        samples.assign(n, 0);
+    }
+
+    size_t index(int x, int y) const { return static_cast<size_t>(y) * width + x; }
+
+    // Soma uma passada aos pixels [x0, x0 + n) da linha 'y': 'pass_rays' raios
+    // e 'pass_seconds' segundos por pixel. Sem 'pass_seconds', reparte os
+    // 'elapsed' segundos da linha proporcionalmente aos raios.
+    void add_row(int x0, int y, int n, const uint32_t* pass_rays, const float* pass_seconds,
+                 int pass_samples, double elapsed) {
+        uint64_t total = 0;
+        for (int i = 0; i < n; i++) total += pass_rays[i];
+        for (int i = 0; i < n; i++) {
+            size_t p = index(x0 + i, y);
+            double share = total ? static_cast<double>(pass_rays[i]) / total : 1.0 / n;
+            seconds[p] += pass_seconds ? pass_seconds[i] : static_cast<float>(elapsed * share);
+            rays[p] += pass_rays[i];
+            samples[p] += pass_samples;
+        }
+    }
+
+    // Grava '<base>_cost.png' (tempo em falsa cor) e '<base>_cost.pfm'
+    // (R = tempo em ms, G = raios, B = raios por amostra)
+    bool write(const std::string& base) const {
+        size_t n = seconds.size();
+        if (n == 0) return false;
+
+        // Normaliza pelo percentil 99 para poucos pixels extremos não
+        // apagarem o resto do mapa
+        std::vector<float> sorted(seconds);
+        size_t p99 = std::min(n - 1, n * 99 / 100);
+        std::nth_element(sorted.begin(), sorted.begin() + p99, sorted.end());
+        float scale = sorted[p99] > 0.0f ? 1.0f / sorted[p99] : 0.0f;
+
+        double total = 0.0;
+        float max_seconds = 0.0f;
+        uint64_t total_rays = 0, total_samples = 0;
+        std::vector<Color> raw(n);
+        std::vector<unsigned char> pixels(n * 3);
+        for (size_t i = 0; i < n; i++) {
+            total += seconds[i];
+            max_seconds = std::max(max_seconds, seconds[i]);
+            total_rays += rays[i];
+            total_samples += samples[i];
+            raw[i] = Color(seconds[i] * 1000.0f, static_cast<float>(rays[i]),
+                           samples[i] ? static_cast<float>(rays[i]) / samples[i] : 0.0f);
+
+            Color c = heat_color(seconds[i] * scale);
+            pixels[i * 3 + 0] = static_cast<unsigned char>(255.99f * c.x);
+            pixels[i * 3 + 1] = static_cast<unsigned char>(255.99f * c.y);
+            pixels[i * 3 + 2] = static_cast<unsigned char>(255.99f * c.z);
+        }
+
+        bool ok = stbi_write_png((base + "_cost.png").c_str(), width, height, 3, pixels.data(), width * 3) != 0;
+        ok = write_pfm(base + "_cost.pfm", width, height, raw.data()) && ok;
+
+        double mean = total / n;
+        std::cout << "Mapa de custo salvo em: " << base << "_cost.{png,pfm}" << std::endl;
+        std::cout << "Custo por pixel: médio " << mean * 1e6 << " us | p99 " << sorted[p99] * 1e6
+                  << " us | máximo " << max_seconds * 1e6 << " us (" << (mean > 0 ? max_seconds / mean : 0.0)
+                  << "x o médio) | " << (total_samples ? static_cast<double>(total_rays) / total_samples : 0.0)
+                  << " raios/amostra" << std::endl;
+        return ok;
+    }
+
+    // Escala preto -> roxo -> vermelho -> laranja -> amarelo -> branco, t em [0, 1]
+    static Color heat_color(float t) {
+        static const Color stops[] = {
+            Color(0.0f, 0.0f, 0.0f), Color(0.35f, 0.05f, 0.55f), Color(0.85f, 0.15f, 0.25f),
+            Color(1.0f, 0.55f, 0.0f), Color(1.0f, 0.95f, 0.2f), Color(1.0f, 1.0f, 1.0f)
+        };
+        const int last = static_cast<int>(sizeof(stops) / sizeof(stops[0])) - 1;
+        t = std::clamp(t, 0.0f, 1.0f) * last;
+        int i = std::min(static_cast<int>(t), last - 1);
+        float f = t - i;
+        return stops[i] * (1.0f - f) + stops[i + 1] * f;
+    }
+};
+
+#endif
@@ -0,0 +1,277 @@
+#ifndef DENOISER_H
+#define DENOISER_H
+
+#include <vector>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <algorithm>
+#include "vec3.h"
+#include "simd.h"
+
+// Denoiser à-trous guiado por AOVs (no estilo do SVGF, sem a parte temporal).
+//
+// A cor é dividida pelo albedo do primeiro acerto (sobra só a iluminação, bem
+// mais suave que a textura) e filtrada por um kernel B3-spline 5x5 aplicado
+// 'iterations' vezes com passo 1, 2, 4, 8... A cada iteração o peso de cada
+// vizinho cai com a diferença de normal, de profundidade e de luminância; a
+// tolerância de luminância acompanha o desvio padrão estimado do pixel, que
+// também é filtrado (ruído alto = filtro mais largo). No final a iluminação
+// filtrada é multiplicada de volta pelo albedo.
+
+struct DenoiseParams {
+    int iterations = 5;
+    int normal_power = 128;         // Expoente de max(0, n_p . n_q) (potência de 2)
+    float sigma_depth = 1.0f;       // Tolerância de profundidade (em gradientes)
+    float sigma_luminance = 4.0f;   // Tolerância de luminância (em desvios padrão)
+};
+
+class AtrousDenoiser {
+public:
+    // Entradas na ordem do framebuffer. 'variance' é a variância da média da
+    // luminância de cada pixel. Pixels sem geometria têm normal (0, 0, 0).
+    std::vector<Color> denoise(int w, int h, const Color* color, const Color* albedo, const Vec3* normal,
+                               const float* depth, const float* variance,
+                               const DenoiseParams& params = DenoiseParams()) {
+        width = w;
+        height = h;
+        size_t n = static_cast<size_t>(w) * h;
+        for (auto* plane : {&r, &g, &b, &var, &nx, &ny, &nz, &z, &zgrad, &lum, &lum_scale,
+                            &r2, &g2, &b2, &var2}) {
+            plane->resize(n);
+        }
+
+        // Demodulação pelo albedo e AOVs em planos SoA
+        std::vector<Color> alb(n);
+        #pragma omp parallel for schedule(static)
+        for (int y = 0; y < h; y++) {
+            for (int x = 0; x < w; x++) {
+                size_t i = static_cast<size_t>(y) * w + x;
+                alb[i] = Color(std::max(albedo[i].x, ALBEDO_EPS), std::max(albedo[i].y, ALBEDO_EPS),
+                               std::max(albedo[i].z, ALBEDO_EPS));
+                r[i] = color[i].x / alb[i].x;
+                g[i] = color[i].y / alb[i].y;
+                b[i] = color[i].z / alb[i].z;
+                float a = std::max(luminance(alb[i]), ALBEDO_EPS);
+                var[i] = variance[i] / (a * a);
+                nx[i] = normal[i].x;
+                ny[i] = normal[i].y;
+                nz[i] = normal[i].z;
+                z[i] = depth[i];
+            }
+        }
+
+        // Gradiente da profundidade (diferenças centrais, em unidades por pixel)
+        #pragma omp parallel for schedule(static)
+        for (int y = 0; y < h; y++) {
+            for (int x = 0; x < w; x++) {
+                size_t i = static_cast<size_t>(y) * w + x;
+                float dx = (z[y * static_cast<size_t>(w) + std::min(x + 1, w - 1)] -
+                            z[y * static_cast<size_t>(w) + std::max(x - 1, 0)]) * 0.5f;
+                float dy = (z[std::min(y + 1, h - 1) * static_cast<size_t>(w) + x] -
+                            z[std::max(y - 1, 0) * static_cast<size_t>(w) + x]) * 0.5f;
+                zgrad[i] = std::max(std::abs(dx), std::abs(dy));
+            }
+        }
+
+        for (int it = 0; it < params.iterations; it++) {
+            prepare_iteration(params);
+            int step = 1 << it;
+            #pragma omp parallel for schedule(dynamic)
+            for (int y = 0; y < h; y++) {
+                filter_row(y, step, params);
+            }
+            r.swap(r2);
+            g.swap(g2);
+            b.swap(b2);
+            var.swap(var2);
+        }
+
+        std::vector<Color> out(n);
+        #pragma omp parallel for schedule(static)
+        for (int i = 0; i < static_cast<int>(n); i++) {
+            out[i] = Color(r[i], g[i], b[i]) * alb[i];
+        }
+        return out;
+    }
+
+private:
+    static constexpr float ALBEDO_EPS = 1e-3f;
+
+    int width = 0, height = 0;
+    std::vector<float> r, g, b, var;        // Iluminação e variância (entrada da iteração)
+    std::vector<float> nx, ny, nz, z, zgrad;
+    std::vector<float> lum, lum_scale;      // Luminância e 1 / (sigma * desvio padrão)
+    std::vector<float> r2, g2, b2, var2;    // Saída da iteração
+
+    // exp(x) para x <= 0 (erro relativo ~1e-6), no mesmo formato do caminho AVX2
+    static float fast_exp(float x) {
+        x = std::max(x, -87.0f);
+        float t = x * 1.44269504f;
+        float i = std::floor(t);
+        float f = t - i;
+        float p = 1.0f + f * (0.69314718f + f * (0.24022652f + f * (0.05550411f + f * (0.00961813f + f * 0.00133336f))));
+        int32_t bits = (static_cast<int32_t>(i) + 127) << 23;
+        float scale;
+        std::memcpy(&scale, &bits, 4);
+        return p * scale;
+    }
+
+    // Luminância da iteração e escala da tolerância pela variância filtrada (3x3 gaussiano)
+    void prepare_iteration(const DenoiseParams& params) {
+        int w = width, h = height;
+        #pragma omp parallel for schedule(static)
+        for (int i = 0; i < w * h; i++) {
+            lum[i] = 0.2126f * r[i] + 0.7152f * g[i] + 0.0722f * b[i];
+        }
+        #pragma omp parallel for schedule(static)
+        for (int y = 0; y < h; y++) {
+            for (int x = 0; x < w; x++) {
+                const float k[2] = {0.25f, 0.125f};
+                float sum = 0.0f, wsum = 0.0f;
+                for (int dy = -1; dy <= 1; dy++) {
+                    int yy = y + dy;
+                    if (yy < 0 || yy >= h) continue;
+                    for (int dx = -1; dx <= 1; dx++) {
+                        int xx = x + dx;
+                        if (xx < 0 || xx >= w) continue;
+                        float kw = k[std::abs(dx)] * k[std::abs(dy)] * 4.0f;
+                        sum += kw * var[static_cast<size_t>(yy) * w + xx];
+                        wsum += kw;
+                    }
+                }
+                lum_scale[static_cast<size_t>(y) * w + x] =
+                    1.0f / (params.sigma_luminance * std::sqrt(std::max(sum / wsum, 0.0f)) + 1e-4f);
+            }
+        }
+    }
+
+    // Filtra os pixels da linha y com o kernel de passo 'step'
+    void filter_row(int y, int step, const DenoiseParams& params) {
+        int x = 0;
+#ifdef PT_SIMD_AVX2
+        // Colunas em que todos os vizinhos caem dentro da imagem, 8 por vez
+        int margin = 2 * step;
+        if (2 * margin + 8 <= width) {
+            for (; x < margin; x++) filter_pixel(x, y, step, params);
+            for (; x + 8 + margin <= width; x += 8) filter8(x, y, step, params);
+        }
+#endif
+        for (; x < width; x++) filter_pixel(x, y, step, params);
+    }
+
+    void filter_pixel(int x, int y, int step, const DenoiseParams& params) {
+        static const float kernel[3] = {3.0f / 8.0f, 1.0f / 4.0f, 1.0f / 16.0f};
+        size_t p = static_cast<size_t>(y) * width + x;
+
+        // Pixel central com peso fixo (pixels de fundo não têm normal)
+        float center = kernel[0] * kernel[0];
+        float sum_w = center;
+        float sum_r = center * r[p], sum_g = center * g[p], sum_b = center * b[p];
+        float sum_var = center * center * var[p];
+
+        for (int dy = -2; dy <= 2; dy++) {
+            int yy = y + dy * step;
+            if (yy < 0 || yy >= height) continue;
+            for (int dx = -2; dx <= 2; dx++) {
+                int xx = x + dx * step;
+                if (xx < 0 || xx >= width || (dx == 0 && dy == 0)) continue;
+                size_t q = static_cast<size_t>(yy) * width + xx;
+
+                float d = std::max(0.0f, nx[p] * nx[q] + ny[p] * ny[q] + nz[p] * nz[q]);
+                for (int k = 1; k < params.normal_power; k *= 2) d *= d;
+
+                float dist = step * std::sqrt(static_cast<float>(dx * dx + dy * dy));
+                float wz = std::abs(z[p] - z[q]) / (params.sigma_depth * zgrad[p] * dist + 1e-3f);
+                float wl = std::abs(lum[p] - lum[q]) * lum_scale[p];
+                float weight = kernel[std::abs(dx)] * kernel[std::abs(dy)] * d * fast_exp(-(wz + wl));
+
+                sum_w += weight;
+                sum_r += weight * r[q];
+                sum_g += weight * g[q];
+                sum_b += weight * b[q];
+                sum_var += weight * weight * var[q];
+            }
+        }
+
+        float inv = 1.0f / sum_w;
+        r2[p] = sum_r * inv;
+        g2[p] = sum_g * inv;
+        b2[p] = sum_b * inv;
+        var2[p] = sum_var * inv * inv;
+    }
+
+#ifdef PT_SIMD_AVX2
+    static __m256 fast_exp8(__m256 x) {
+        x = _mm256_max_ps(x, _mm256_set1_ps(-87.0f));
+        __m256 t = _mm256_mul_ps(x, _mm256_set1_ps(1.44269504f));
+        __m256 i = _mm256_floor_ps(t);
+        __m256 f = _mm256_sub_ps(t, i);
+        __m256 p = _mm256_set1_ps(0.00133336f);
+        p = _mm256_fmadd_ps(p, f, _mm256_set1_ps(0.00961813f));
+        p = _mm256_fmadd_ps(p, f, _mm256_set1_ps(0.05550411f));
+        p = _mm256_fmadd_ps(p, f, _mm256_set1_ps(0.24022652f));
+        p = _mm256_fmadd_ps(p, f, _mm256_set1_ps(0.69314718f));
+        p = _mm256_fmadd_ps(p, f, _mm256_set1_ps(1.0f));
+        __m256i bits = _mm256_slli_epi32(_mm256_add_epi32(_mm256_cvtps_epi32(i), _mm256_set1_epi32(127)), 23);
+        return _mm256_mul_ps(p, _mm256_castsi256_ps(bits));
+    }
+
+    // Mesmo cálculo de filter_pixel para os pixels x..x+7 (vizinhos dentro da imagem na horizontal)
+    void filter8(int x, int y, int step, const DenoiseParams& params) {
+        static const float kernel[3] = {3.0f / 8.0f, 1.0f / 4.0f, 1.0f / 16.0f};
+        size_t p = static_cast<size_t>(y) * width + x;
+        const __m256 zero = _mm256_setzero_ps();
+        const __m256 abs_mask = _mm256_castsi256_ps(_mm256_set1_epi32(0x7fffffff));
+
+        __m256 pnx = _mm256_loadu_ps(&nx[p]), pny = _mm256_loadu_ps(&ny[p]), pnz = _mm256_loadu_ps(&nz[p]);
+        __m256 pz = _mm256_loadu_ps(&z[p]);
+        __m256 pzgrad = _mm256_mul_ps(_mm256_loadu_ps(&zgrad[p]), _mm256_set1_ps(params.sigma_depth));
+        __m256 plum = _mm256_loadu_ps(&lum[p]);
+        __m256 pscale = _mm256_loadu_ps(&lum_scale[p]);
+
+        __m256 center = _mm256_set1_ps(kernel[0] * kernel[0]);
+        __m256 sum_w = center;
+        __m256 sum_r = _mm256_mul_ps(center, _mm256_loadu_ps(&r[p]));
+        __m256 sum_g = _mm256_mul_ps(center, _mm256_loadu_ps(&g[p]));
+        __m256 sum_b = _mm256_mul_ps(center, _mm256_loadu_ps(&b[p]));
+        __m256 sum_var = _mm256_mul_ps(_mm256_mul_ps(center, center), _mm256_loadu_ps(&var[p]));
+
+        for (int dy = -2; dy <= 2; dy++) {
+            int yy = y + dy * step;
+            if (yy < 0 || yy >= height) continue;
+            for (int dx = -2; dx <= 2; dx++) {
+                if (dx == 0 && dy == 0) continue;
+                size_t q = static_cast<size_t>(yy) * width + x + dx * step;
+
+                __m256 d = _mm256_fmadd_ps(pnx, _mm256_loadu_ps(&nx[q]),
+                           _mm256_fmadd_ps(pny, _mm256_loadu_ps(&ny[q]),
+                           _mm256_mul_ps(pnz, _mm256_loadu_ps(&nz[q]))));
+                d = _mm256_max_ps(d, zero);
+                for (int k = 1; k < params.normal_power; k *= 2) d = _mm256_mul_ps(d, d);
+
+                float dist = step * std::sqrt(static_cast<float>(dx * dx + dy * dy));
+                __m256 wz = _mm256_div_ps(_mm256_and_ps(_mm256_sub_ps(pz, _mm256_loadu_ps(&z[q])), abs_mask),
+                                          _mm256_fmadd_ps(pzgrad, _mm256_set1_ps(dist), _mm256_set1_ps(1e-3f)));
+                __m256 wl = _mm256_mul_ps(_mm256_and_ps(_mm256_sub_ps(plum, _mm256_loadu_ps(&lum[q])), abs_mask), pscale);
+                __m256 weight = _mm256_mul_ps(_mm256_set1_ps(kernel[std::abs(dx)] * kernel[std::abs(dy)]), d);
+                weight = _mm256_mul_ps(weight, fast_exp8(_mm256_sub_ps(zero, _mm256_add_ps(wz, wl))));
+
+                sum_w = _mm256_add_ps(sum_w, weight);
+                sum_r = _mm256_fmadd_ps(weight, _mm256_loadu_ps(&r[q]), sum_r);
+                sum_g = _mm256_fmadd_ps(weight, _mm256_loadu_ps(&g[q]), sum_g);
+                sum_b = _mm256_fmadd_ps(weight, _mm256_loadu_ps(&b[q]), sum_b);
+                sum_var = _mm256_fmadd_ps(_mm256_mul_ps(weight, weight), _mm256_loadu_ps(&var[q]), sum_var);
+            }
+        }
+
+        __m256 inv = _mm256_div_ps(_mm256_set1_ps(1.0f), sum_w);
+        _mm256_storeu_ps(&r2[p], _mm256_mul_ps(sum_r, inv));
+        _mm256_storeu_ps(&g2[p], _mm256_mul_ps(sum_g, inv));
+        _mm256_storeu_ps(&b2[p], _mm256_mul_ps(sum_b, inv));
+        _mm256_storeu_ps(&var2[p], _mm256_mul_ps(sum_var, _mm256_mul_ps(inv, inv)));
+    }
+#endif
+};
+
+#endif
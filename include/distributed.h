@@ -0,0 +1,224 @@
+#ifndef DISTRIBUTED_H
+#define DISTRIBUTED_H
+
+#include <cstdio>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <algorithm>
+#include <filesystem>
+#include <system_error>
+#include "checkpoint.h"
+
+// Renderização distribuída em vários processos (na mesma máquina ou em
+// máquinas que enxergam o mesmo sistema de arquivos).
+//
+// A imagem é dividida em shards: um bloco de pixels e um intervalo de
+// passadas. A semente de cada linha depende só de (semente, passada, linha,
+// coluna inicial do bloco), então o resultado de um shard é o mesmo em
+// qualquer processo e um shard refeito sobrescreve o anterior sem mudar nada.
+// Cada shard gera um checkpoint parcial (checkpoint.h) e a imagem final é a
+// soma deles.
+
+namespace fs = std::filesystem;
+
+// Bloco [x0, x1) x [y0, y1) (linhas do framebuffer, 0 = topo) nas passadas [pass_begin, pass_end)
+struct ShardSpec {
+    int x0 = 0, y0 = 0, x1 = 0, y1 = 0;
+    int pass_begin = 0, pass_end = 0;
+
+    std::string to_string() const {
+        std::ostringstream out;
+        out << x0 << "," << y0 << "," << x1 << "," << y1 << "," << pass_begin << "," << pass_end;
+        return out.str();
+    }
+
+    // Formato "x0,y0,x1,y1,passada_inicial,passada_final"
+    bool parse(const std::string& text, int width, int height) {
+        char c1, c2, c3, c4, c5;
+        std::istringstream in(text);
+        if (!(in >> x0 >> c1 >> y0 >> c2 >> x1 >> c3 >> y1 >> c4 >> pass_begin >> c5 >> pass_end)) return false;
+        if (c1 != ',' || c2 != ',' || c3 != ',' || c4 != ',' || c5 != ',') return false;
+        return x0 >= 0 && y0 >= 0 && x1 <= width && y1 <= height && x0 < x1 && y0 < y1 &&
+               pass_begin >= 0 && pass_begin < pass_end;
+    }
+};
+
+// Grade de tiles_x x tiles_y blocos, cada um com as passadas divididas em
+// 'sample_shards' intervalos. Sempre a mesma partição para os mesmos parâmetros.
+inline std::vector<ShardSpec> make_shards(int width, int height, int total_passes,
+                                          int tiles_x, int tiles_y, int sample_shards) {
+    tiles_x = std::clamp(tiles_x, 1, width);
+    tiles_y = std::clamp(tiles_y, 1, height);
+    sample_shards = std::clamp(sample_shards, 1, total_passes);
+
+    std::vector<ShardSpec> shards;
+    for (int s = 0; s < sample_shards; s++) {
+        for (int ty = 0; ty < tiles_y; ty++) {
+            for (int tx = 0; tx < tiles_x; tx++) {
+                ShardSpec shard;
+                shard.x0 = width * tx / tiles_x;
+                shard.x1 = width * (tx + 1) / tiles_x;
+                shard.y0 = height * ty / tiles_y;
+                shard.y1 = height * (ty + 1) / tiles_y;
+                shard.pass_begin = total_passes * s / sample_shards;
+                shard.pass_end = total_passes * (s + 1) / sample_shards;
+                shards.push_back(shard);
+            }
+        }
+    }
+    return shards;
+}
+
+// Um trabalho da fila: shard + semente + hash esperado da cena
+struct Job {
+    std::string name;
+    ShardSpec shard;
+    uint64_t seed = 0;
+    uint64_t scene_hash = 0;
+};
+
+// Fila num diretório compartilhado:
+//   pending/<job>.txt  esperando um worker
+//   claimed/<job>.txt  em andamento (o worker atualiza a data a cada passada)
+//   done/<job>.ptck    checkpoint parcial pronto
+//   config.txt         configuração do coordenador (render_config.h), lida pelos workers
+// Um worker pega um trabalho renomeando pending/ -> claimed/; o rename é
+// atômico, então só um processo consegue. Trabalhos em claimed/ sem
+// atualização há muito tempo (worker morto) voltam para pending/.
+class WorkQueue {
+public:
+    fs::path root;
+
+    explicit WorkQueue(const fs::path& dir) : root(dir) {}
+
+    // Cria a fila com os shards (se ela ainda não existir) e grava 'settings'
+    // em config.txt. Retorna o número de trabalhos.
+    int create(const std::vector<ShardSpec>& shards, uint64_t seed, uint64_t scene_hash,
+               const std::string& settings) {
+        std::error_code ec;
+        fs::create_directories(root / "pending", ec);
+        fs::create_directories(root / "claimed", ec);
+        fs::create_directories(root / "done", ec);
+
+        int existing = total_jobs();
+        if (existing > 0) return existing;
+
+        // Antes dos trabalhos: um worker que já encontra um trabalho também encontra a configuração
+        {
+            std::ofstream out(root / "config.tmp");
+            out << settings;
+        }
+        fs::rename(root / "config.tmp", config_path(), ec);
+        for (size_t i = 0; i < shards.size(); i++) {
+            char name[32];
+            std::snprintf(name, sizeof(name), "job_%05zu", i);
+            // Escreve fora de pending/ para nenhum worker ler um arquivo pela metade
+            fs::path tmp = root / (std::string(name) + ".tmp");
+            {
+                std::ofstream out(tmp);
+                out << shards[i].to_string() << "\n" << seed << "\n" << scene_hash << "\n";
+            }
+            fs::rename(tmp, root / "pending" / (std::string(name) + ".txt"), ec);
+        }
+        std::ofstream(root / "jobs.txt") << shards.size() << "\n";
+        return static_cast<int>(shards.size());
+    }
+
+    fs::path config_path() const { return root / "config.txt"; }
+
+    int total_jobs() const {
+        std::ifstream in(root / "jobs.txt");
+        int n = 0;
+        return (in >> n) ? n : 0;
+    }
+
+    // Tenta pegar o próximo trabalho pendente. Um trabalho com hash diferente
+    // de 'scene_hash' (outra cena, resolução ou configuração) é devolvido sem
+    // validar o bloco: quem chamou compara job.scene_hash e desiste.
+    bool claim(Job& job, int width, int height, uint64_t scene_hash) {
+        for (const auto& name : list(root / "pending", ".txt")) {
+            std::error_code ec;
+            fs::rename(root / "pending" / (name + ".txt"), root / "claimed" / (name + ".txt"), ec);
+            if (ec) continue; // Outro processo chegou antes
+
+            std::ifstream in(root / "claimed" / (name + ".txt"));
+            std::string spec;
+            job.name = name;
+            if (in >> spec >> job.seed >> job.scene_hash &&
+                (job.scene_hash != scene_hash || job.shard.parse(spec, width, height))) {
+                heartbeat(job);
+                return true;
+            }
+            std::cerr << "AVISO: trabalho inválido descartado: " << name << std::endl;
+            fs::remove(root / "claimed" / (name + ".txt"), ec);
+        }
+        return false;
+    }
+
+    // Marca o trabalho como vivo
+    void heartbeat(const Job& job) {
+        std::error_code ec;
+        fs::last_write_time(root / "claimed" / (job.name + ".txt"), fs::file_time_type::clock::now(), ec);
+    }
+
+    // Grava o resultado (atomicamente) e libera o trabalho
+    bool complete(const Job& job, const Checkpoint& result) {
+        if (!result.save((root / "done" / (job.name + ".ptck")).string())) return false;
+        std::error_code ec;
+        fs::remove(root / "claimed" / (job.name + ".txt"), ec);
+        return true;
+    }
+
+    // Devolve o trabalho para a fila sem resultado
+    void release(const Job& job) {
+        std::error_code ec;
+        fs::rename(root / "claimed" / (job.name + ".txt"), root / "pending" / (job.name + ".txt"), ec);
+    }
+
+    // Devolve para pending/ os trabalhos parados há mais de 'timeout_sec' segundos
+    int requeue_stale(double timeout_sec) {
+        int requeued = 0;
+        auto now = fs::file_time_type::clock::now();
+        for (const auto& name : list(root / "claimed", ".txt")) {
+            std::error_code ec;
+            fs::path claimed = root / "claimed" / (name + ".txt");
+            auto age = std::chrono::duration<double>(now - fs::last_write_time(claimed, ec)).count();
+            if (ec || age < timeout_sec) continue;
+            if (fs::exists(root / "done" / (name + ".ptck"))) {
+                fs::remove(claimed, ec);
+                continue;
+            }
+            fs::rename(claimed, root / "pending" / (name + ".txt"), ec);
+            if (!ec) requeued++;
+        }
+        return requeued;
+    }
+
+    // Checkpoints parciais prontos
+    std::vector<std::string> done_files() const {
+        std::vector<std::string> files;
+        for (const auto& name : list(root / "done", ".ptck")) {
+            files.push_back((root / "done" / (name + ".ptck")).string());
+        }
+        return files;
+    }
+
+private:
+    // Nomes (sem extensão) dos arquivos com a extensão dada, em ordem
+    static std::vector<std::string> list(const fs::path& dir, const std::string& extension) {
+        std::vector<std::string> names;
+        std::error_code ec;
+        for (const auto& entry : fs::directory_iterator(dir, ec)) {
+            if (entry.path().extension() == extension) names.push_back(entry.path().stem().string());
+        }
+        std::sort(names.begin(), names.end());
+        return names;
+    }
+};
+
+#endif
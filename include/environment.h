@@ -0,0 +1,161 @@
+#ifndef ENVIRONMENT_H
+#define ENVIRONMENT_H
+
+#include <cmath>
+#include <cctype>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include "vec3.h"
+#include "image_io.h"
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+// Iluminação de ambiente por um mapa HDR em latitude-longitude (.hdr ou PFM):
+// a coluna dá o azimute (o centro da imagem fica em -z, a direita em +x) e a
+// linha a altura (topo = +y). Os raios que saem da cena recebem a cor do
+// texel da sua direção.
+//
+// Para a luz direta, as direções são sorteadas com densidade proporcional à
+// luminância de cada texel vezes o seno da latitude (a área do texel na
+// esfera): uma distribuição marginal sobre as linhas e uma condicional sobre
+// as colunas de cada linha, invertidas pelas CDFs. Um sol pequeno e forte
+// recebe quase todas as amostras em vez de depender do rebote acertá-lo.
+class EnvironmentMap {
+public:
+    // Lê o mapa ('scale' multiplica a radiância; 'rotation_degrees' gira em
+    // torno do eixo vertical). Em caso de erro, 'error' diz o motivo.
+    bool load(const std::string& path, float scale, float rotation_degrees, std::string& error) {
+        int w = 0, h = 0;
+        std::vector<Color> image;
+        std::string ext = path.size() >= 4 ? path.substr(path.size() - 4) : "";
+        std::transform(ext.begin(), ext.end(), ext.begin(), [](unsigned char c) { return std::tolower(c); });
+        bool ok = ext == ".pfm" ? read_pfm(path, w, h, image) : read_hdr(path, w, h, image);
+        if (!ok) {
+            error = "não foi possível ler o mapa de ambiente " + path + " (.hdr RGBE ou .pfm)";
+            return false;
+        }
+        build(w, h, std::move(image), scale, rotation_degrees);
+        return true;
+    }
+
+    // Usa 'image' (w x h, linha 0 = topo) como mapa e monta as distribuições
+    void build(int w, int h, std::vector<Color> image, float scale, float rotation_degrees) {
+        width_ = w;
+        height_ = h;
+        texels_ = std::move(image);
+        for (Color& c : texels_) c = c * scale;
+        rotation_ = rotation_degrees * static_cast<float>(M_PI) / 180.0f;
+
+        // Peso de cada texel: luminância x seno da latitude no centro da linha
+        conditional_cdf_.assign(static_cast<size_t>(h) * (w + 1), 0.0f);
+        marginal_cdf_.assign(h + 1, 0.0f);
+        std::vector<double> row_sums(h, 0.0);
+        double total = 0.0;
+        for (int y = 0; y < h; y++) {
+            float sin_theta = std::sin((y + 0.5f) * static_cast<float>(M_PI) / h);
+            float* cdf = conditional_cdf_.data() + static_cast<size_t>(y) * (w + 1);
+            double row = 0.0;
+            for (int x = 0; x < w; x++) {
+                row += std::max(luminance(texels_[static_cast<size_t>(y) * w + x]), 0.0f) * sin_theta;
+                cdf[x + 1] = static_cast<float>(row);
+            }
+            // CDF da linha normalizada; linha toda preta vira uniforme (nunca é sorteada)
+            for (int x = 1; x <= w; x++) cdf[x] = row > 0.0 ? static_cast<float>(cdf[x] / row) : float(x) / w;
+            cdf[w] = 1.0f;
+            row_sums[y] = row;
+            total += row;
+        }
+        double acc = 0.0;
+        for (int y = 0; y < h; y++) {
+            acc += row_sums[y];
+            marginal_cdf_[y + 1] = total > 0.0 ? static_cast<float>(acc / total) : float(y + 1) / h;
+        }
+        marginal_cdf_[h] = 1.0f;
+        total_ = total;
+    }
+
+    bool loaded() const { return !texels_.empty(); }
+    int width() const { return width_; }
+    int height() const { return height_; }
+    const std::vector<Color>& texels() const { return texels_; }
+    float rotation() const { return rotation_; }
+
+    // Radiância vinda da direção unitária 'dir'
+    Color eval(const Vec3& dir) const {
+        int x, y;
+        texel_of(dir, x, y);
+        return texels_[static_cast<size_t>(y) * width_ + x];
+    }
+
+    // Sorteia uma direção (u1 escolhe a linha, u2 a coluna). 'pdf' recebe a
+    // densidade por ângulo sólido (0 = mapa todo preto).
+    Vec3 sample(float u1, float u2, float& pdf) const {
+        int y = find_interval(marginal_cdf_.data(), height_, u1);
+        const float* cdf = conditional_cdf_.data() + static_cast<size_t>(y) * (width_ + 1);
+        int x = find_interval(cdf, width_, u2);
+
+        // Posição contínua dentro do texel
+        float dv = (u1 - marginal_cdf_[y]) / std::max(marginal_cdf_[y + 1] - marginal_cdf_[y], 1e-12f);
+        float du = (u2 - cdf[x]) / std::max(cdf[x + 1] - cdf[x], 1e-12f);
+        float u = (x + std::clamp(du, 0.0f, 1.0f)) / width_;
+        float v = (y + std::clamp(dv, 0.0f, 1.0f)) / height_;
+
+        float theta = v * static_cast<float>(M_PI);
+        float phi = (u - 0.5f) * 2.0f * static_cast<float>(M_PI) + rotation_;
+        float sin_theta = std::sin(theta);
+        Vec3 dir(sin_theta * std::sin(phi), std::cos(theta), -sin_theta * std::cos(phi));
+        pdf = pdf_texel(x, y, sin_theta);
+        return dir;
+    }
+
+    // Densidade por ângulo sólido com que sample() gera a direção unitária 'dir'
+    float pdf(const Vec3& dir) const {
+        int x, y;
+        texel_of(dir, x, y);
+        float sin_theta = std::sqrt(std::max(0.0f, 1.0f - dir.y * dir.y));
+        return pdf_texel(x, y, sin_theta);
+    }
+
+private:
+    int width_ = 0, height_ = 0;
+    std::vector<Color> texels_;
+    float rotation_ = 0.0f;                 // Radianos em torno de +y
+    std::vector<float> conditional_cdf_;    // Por linha: width + 1 valores de 0 a 1
+    std::vector<float> marginal_cdf_;       // height + 1 valores de 0 a 1
+    double total_ = 0.0;
+
+    void texel_of(const Vec3& dir, int& x, int& y) const {
+        float theta = std::acos(std::clamp(dir.y, -1.0f, 1.0f));
+        float phi = std::atan2(dir.x, -dir.z) - rotation_;
+        float u = phi / (2.0f * static_cast<float>(M_PI)) + 0.5f;
+        u -= std::floor(u);
+        float v = theta / static_cast<float>(M_PI);
+        x = std::min(static_cast<int>(u * width_), width_ - 1);
+        y = std::min(static_cast<int>(v * height_), height_ - 1);
+    }
+
+    // Densidade do texel em (u, v) convertida para ângulo sólido:
+    // p(dir) = p(u, v) / (2 pi² sin theta)
+    float pdf_texel(int x, int y, float sin_theta) const {
+        if (total_ <= 0.0 || sin_theta <= 0.0f) return 0.0f;
+        const float* cdf = conditional_cdf_.data() + static_cast<size_t>(y) * (width_ + 1);
+        float p_row = marginal_cdf_[y + 1] - marginal_cdf_[y];
+        float p_col = cdf[x + 1] - cdf[x];
+        float pdf_uv = p_row * p_col * width_ * height_;
+        return pdf_uv / (2.0f * static_cast<float>(M_PI * M_PI) * sin_theta);
+    }
+
+    // Maior i em [0, n) com cdf[i] <= u
+    static int find_interval(const float* cdf, int n, float u) {
+        int i = static_cast<int>(std::upper_bound(cdf, cdf + n + 1, u) - cdf) - 1;
+        // Pula intervalos vazios (peso zero) que a busca pode devolver nas bordas
+        i = std::clamp(i, 0, n - 1);
+        while (i < n - 1 && cdf[i + 1] <= cdf[i]) i++;
+        return i;
+    }
+};
+
+#endif
@@ -0,0 +1,647 @@
+#ifndef IMAGE_IO_H
+#define IMAGE_IO_H
+
+#include <cmath>
+#include <cstdio>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <cstdlib>
+#include <algorithm>
+#include "vec3.h"
+#include "stb_image_write.h"
+
+// Saída HDR em ponto flutuante linear (sem clamp nem gamma), para aplicar
+// exposição e tonemapping depois sem renderizar de novo.
+// Todos os buffers estão na ordem do framebuffer: linha 0 = topo da imagem.
+
+static_assert(sizeof(Color) == 3 * sizeof(float), "Color precisa ser 3 floats contíguos");
+
+// Portable Float Map (RGB, little-endian). As linhas do PFM vão de baixo para cima.
+inline bool write_pfm(const std::string& path, int width, int height, const Color* data) {
+    FILE* f = std::fopen(path.c_str(), "wb");
+    if (!f) return false;
+
+    std::fprintf(f, "PF\n%d %d\n-1.0\n", width, height);
+    for (int y = height - 1; y >= 0; y--) {
+        std::fwrite(data + static_cast<size_t>(y) * width, sizeof(Color), width, f);
+    }
+    return std::fclose(f) == 0;
+}
+
+// Leitura de PFM RGB (grava em 'data' na ordem do framebuffer)
+inline bool read_pfm(const std::string& path, int& width, int& height, std::vector<Color>& data) {
+    FILE* f = std::fopen(path.c_str(), "rb");
+    if (!f) return false;
+
+    char magic[3] = {0, 0, 0};
+    float scale = 0.0f;
+    bool ok = std::fscanf(f, "%2s %d %d %f", magic, &width, &height, &scale) == 4 &&
+              std::strcmp(magic, "PF") == 0 && width > 0 && height > 0 && scale < 0.0f; // Só little-endian
+    ok = ok && std::fgetc(f) != EOF; // Um caractere de espaço antes dos dados
+    if (ok) {
+        data.resize(static_cast<size_t>(width) * height);
+        for (int y = height - 1; y >= 0 && ok; y--) {
+            ok = std::fread(data.data() + static_cast<size_t>(y) * width, sizeof(Color), width, f) ==
+                 static_cast<size_t>(width);
+        }
+    }
+    std::fclose(f);
+    return ok;
+}
+
+// Radiance RGBE (.hdr) pelo stb_image_write
+inline bool write_hdr(const std::string& path, int width, int height, const Color* data) {
+    return stbi_write_hdr(path.c_str(), width, height, 3, reinterpret_cast<const float*>(data)) != 0;
+}
+
+// Leitura de Radiance RGBE (.hdr) com orientação -Y +X (a usual, e a do
+// stb_image_write). Linhas planas ou com o RLE "novo" por canal; o RLE antigo
+// (anterior a 1991) não é aceito. Grava em 'data' na ordem do framebuffer.
+inline bool read_hdr(const std::string& path, int& width, int& height, std::vector<Color>& data) {
+    FILE* f = std::fopen(path.c_str(), "rb");
+    if (!f) return false;
+
+    // Cabeçalho: "#?RADIANCE", variáveis até uma linha vazia, depois a resolução
+    char line[512];
+    bool ok = std::fgets(line, sizeof(line), f) && std::strncmp(line, "#?", 2) == 0;
+    while (ok) {
+        ok = std::fgets(line, sizeof(line), f) != nullptr;
+        if (!ok || line[0] == '\n' || line[0] == '\r') break;
+        if (std::strncmp(line, "FORMAT=", 7) == 0 && std::strncmp(line, "FORMAT=32-bit_rle_rgbe", 22) != 0) {
+            ok = false; // XYZE não é suportado
+        }
+    }
+    ok = ok && std::fgets(line, sizeof(line), f) && std::sscanf(line, "-Y %d +X %d", &height, &width) == 2 &&
+         width > 0 && height > 0;
+
+    if (ok) data.resize(static_cast<size_t>(width) * height);
+    std::vector<uint8_t> scan(static_cast<size_t>(width) * 4);    // Canais em planos: R..., G..., B..., E...
+    for (int y = 0; y < height && ok; y++) {
+        int c0 = std::fgetc(f), c1 = std::fgetc(f), c2 = std::fgetc(f), c3 = std::fgetc(f);
+        if (c3 == EOF) {
+            ok = false;
+        } else if (width >= 8 && width < 32768 && c0 == 2 && c1 == 2 && !(c2 & 0x80)) {
+            // RLE: cada canal em sequência, corridas (> 128) ou trechos literais
+            ok = ((c2 << 8) | c3) == width;
+            for (int ch = 0; ch < 4 && ok; ch++) {
+                uint8_t* plane = scan.data() + static_cast<size_t>(ch) * width;
+                for (int x = 0; x < width && ok;) {
+                    int count = std::fgetc(f);
+                    if (count == EOF || count == 0) { ok = false; break; }
+                    if (count > 128) {
+                        count -= 128;
+                        int value = std::fgetc(f);
+                        ok = value != EOF && x + count <= width;
+                        if (ok) std::memset(plane + x, value, count);
+                    } else {
+                        ok = x + count <= width &&
+                             std::fread(plane + x, 1, count, f) == static_cast<size_t>(count);
+                    }
+                    x += count;
+                }
+            }
+        } else {
+            // Plano: os 4 bytes já lidos são o primeiro pixel
+            std::vector<uint8_t> rgbe(static_cast<size_t>(width) * 4);
+            rgbe[0] = static_cast<uint8_t>(c0);
+            rgbe[1] = static_cast<uint8_t>(c1);
+            rgbe[2] = static_cast<uint8_t>(c2);
+            rgbe[3] = static_cast<uint8_t>(c3);
+            ok = std::fread(rgbe.data() + 4, 4, width - 1, f) == static_cast<size_t>(width - 1);
+            for (int x = 0; x < width && ok; x++) {
+                for (int ch = 0; ch < 4; ch++) scan[static_cast<size_t>(ch) * width + x] = rgbe[x * 4 + ch];
+            }
+        }
+
+        for (int x = 0; x < width && ok; x++) {
+            int e = scan[3 * width + x];
+            float scale = e == 0 ? 0.0f : std::ldexp(1.0f, e - (128 + 8));
+            data[static_cast<size_t>(y) * width + x] =
+                Color(scan[x] * scale, scan[width + x] * scale, scan[2 * width + x] * scale);
+        }
+    }
+    std::fclose(f);
+    return ok;
+}
+
+// ----------------------------------------------------------------------------
+// OpenEXR (scanline, canais B/G/R em float 32, uma linha por bloco)
+// ----------------------------------------------------------------------------
+
+enum ExrCompression {
+    EXR_NONE = 0,
+    EXR_RLE = 1
+};
+
+namespace exr_detail {
+
+inline void put_u8(std::vector<uint8_t>& out, uint8_t v) { out.push_back(v); }
+
+inline void put_i32(std::vector<uint8_t>& out, int32_t v) {
+    for (int i = 0; i < 4; i++) out.push_back(static_cast<uint8_t>((static_cast<uint32_t>(v) >> (8 * i)) & 0xff));
+}
+
+inline void put_u64(std::vector<uint8_t>& out, uint64_t v) {
+    for (int i = 0; i < 8; i++) out.push_back(static_cast<uint8_t>((v >> (8 * i)) & 0xff));
+}
+
+inline void put_f32(std::vector<uint8_t>& out, float v) {
+    uint32_t bits;
+    std::memcpy(&bits, &v, 4);
+    put_i32(out, static_cast<int32_t>(bits));
+}
+
+inline void put_str(std::vector<uint8_t>& out, const char* s) {
+    while (*s) out.push_back(static_cast<uint8_t>(*s++));
+    out.push_back(0);
+}
+
+inline void put_attr(std::vector<uint8_t>& out, const char* name, const char* type, int32_t size) {
+    put_str(out, name);
+    put_str(out, type);
+    put_i32(out, size);
+}
+
+// Compressão RLE do OpenEXR: separa bytes pares/ímpares, aplica o preditor
+// por diferença e codifica corridas (mesmo algoritmo do ImfRleCompressor)
+inline std::vector<uint8_t> rle_compress(const std::vector<uint8_t>& in) {
+    size_t n = in.size();
+    std::vector<uint8_t> tmp(n);
+
+    size_t half = (n + 1) / 2;
+    for (size_t i = 0; i < n; i++) {
+        tmp[(i % 2 == 0) ? i / 2 : half + i / 2] = in[i];
+    }
+
+    int p = n ? tmp[0] : 0;
+    for (size_t i = 1; i < n; i++) {
+        int d = static_cast<int>(tmp[i]) - p + (128 + 256);
+        p = tmp[i];
+        tmp[i] = static_cast<uint8_t>(d);
+    }
+
+    const size_t MIN_RUN = 3, MAX_RUN = 127;
+    std::vector<uint8_t> out;
+    out.reserve(n + n / 64 + 2);
+    size_t run_start = 0, run_end = 1;
+    while (run_start < n) {
+        while (run_end < n && tmp[run_start] == tmp[run_end] && run_end - run_start - 1 < MAX_RUN) {
+            run_end++;
+        }
+        if (run_end - run_start >= MIN_RUN) {
+            // Corrida comprimível: (comprimento - 1, valor)
+            out.push_back(static_cast<uint8_t>(run_end - run_start - 1));
+            out.push_back(tmp[run_start]);
+            run_start = run_end;
+        } else {
+            // Trecho literal: (-comprimento, bytes...)
+            while (run_end < n &&
+                   ((run_end + 1 >= n || tmp[run_end] != tmp[run_end + 1]) ||
+                    (run_end + 2 >= n || tmp[run_end + 1] != tmp[run_end + 2])) &&
+                   run_end - run_start < MAX_RUN) {
+                run_end++;
+            }
+            out.push_back(static_cast<uint8_t>(-static_cast<int>(run_end - run_start)));
+            while (run_start < run_end) out.push_back(tmp[run_start++]);
+        }
+        run_end++;
+    }
+    return out;
+}
+
+} // namespace exr_detail
+
+inline bool write_exr(const std::string& path, int width, int height, const Color* data,
+                      ExrCompression compression = EXR_RLE) {
+    using namespace exr_detail;
+    std::vector<uint8_t> header;
+
+    // Número mágico + versão 2, arquivo scanline simples
+    put_i32(header, 20000630);
+    put_i32(header, 2);
+
+    // Canais em ordem alfabética: B, G, R (FLOAT = 2, amostragem 1x1)
+    put_attr(header, "channels", "chlist", 3 * 18 + 1);
+    for (const char* name : {"B", "G", "R"}) {
+        put_str(header, name);
+        put_i32(header, 2);
+        put_u8(header, 0); put_u8(header, 0); put_u8(header, 0); put_u8(header, 0);
+        put_i32(header, 1);
+        put_i32(header, 1);
+    }
+    put_u8(header, 0);
+
+    put_attr(header, "compression", "compression", 1);
+    put_u8(header, static_cast<uint8_t>(compression));
+
+    for (const char* window : {"dataWindow", "displayWindow"}) {
+        put_attr(header, window, "box2i", 16);
+        put_i32(header, 0);
+        put_i32(header, 0);
+        put_i32(header, width - 1);
+        put_i32(header, height - 1);
+    }
+
+    put_attr(header, "lineOrder", "lineOrder", 1);
+    put_u8(header, 0); // INCREASING_Y
+
+    put_attr(header, "pixelAspectRatio", "float", 4);
+    put_f32(header, 1.0f);
+
+    put_attr(header, "screenWindowCenter", "v2f", 8);
+    put_f32(header, 0.0f);
+    put_f32(header, 0.0f);
+
+    put_attr(header, "screenWindowWidth", "float", 4);
+    put_f32(header, 1.0f);
+
+    put_u8(header, 0); // Fim do cabeçalho
+
+    // Blocos: uma linha cada, canais separados (B..., G..., R...)
+    std::vector<std::vector<uint8_t>> blocks(height);
+    #pragma omp parallel for schedule(dynamic)
+    for (int y = 0; y < height; y++) {
+        std::vector<uint8_t> line;
+        line.reserve(static_cast<size_t>(width) * 12);
+        const Color* row = data + static_cast<size_t>(y) * width;
+        for (int c = 2; c >= 0; c--) {
+            for (int x = 0; x < width; x++) {
+                put_f32(line, c == 0 ? row[x].x : c == 1 ? row[x].y : row[x].z);
+            }
+        }
+
+        if (compression == EXR_RLE) {
+            // Se não compensar, o bloco vai cru (o leitor detecta pelo tamanho)
+            std::vector<uint8_t> packed = rle_compress(line);
+            if (packed.size() < line.size()) line.swap(packed);
+        }
+
+        std::vector<uint8_t>& block = blocks[y];
+        put_i32(block, y);
+        put_i32(block, static_cast<int32_t>(line.size()));
+        block.insert(block.end(), line.begin(), line.end());
+    }
+
+    // Tabela de offsets (absolutos) de cada bloco
+    std::vector<uint8_t> offsets;
+    uint64_t offset = header.size() + static_cast<uint64_t>(height) * 8;
+    for (int y = 0; y < height; y++) {
+        put_u64(offsets, offset);
+        offset += blocks[y].size();
+    }
+
+    FILE* f = std::fopen(path.c_str(), "wb");
+    if (!f) return false;
+    std::fwrite(header.data(), 1, header.size(), f);
+    std::fwrite(offsets.data(), 1, offsets.size(), f);
+    for (const auto& block : blocks) {
+        std::fwrite(block.data(), 1, block.size(), f);
+    }
+    return std::fclose(f) == 0;
+}
+
+// ----------------------------------------------------------------------------
+// PNG RGB de 8 bits com codificação paralela
+// ----------------------------------------------------------------------------
+// O stbi_write_png filtra e comprime a imagem inteira numa thread só. Aqui a
+// imagem é dividida em faixas de 'strip_rows' linhas: cada faixa é filtrada e
+// comprimida (deflate com códigos de Huffman fixos, como o stb) em paralelo,
+// com o dicionário reiniciado no começo dela. As faixas terminam alinhadas em
+// byte com um bloco "stored" vazio (o sync flush do zlib), de modo que os
+// pedaços emendados formam um único fluxo zlib, gravado com um chunk IDAT por
+// faixa. O tamanho das faixas é fixo: o arquivo não depende do número de threads.
+//
+// Nível 0 = sem compressão (blocos stored), 1..9 = mais candidatos por posição
+// na busca de repetições (a partir do 4, com avaliação preguiçosa).
+
+namespace png_detail {
+
+inline uint32_t crc32(const uint8_t* data, size_t n, uint32_t crc = 0) {
+    // Tabela sem destrutor: pode ser usada por threads que terminam depois de main()
+    static const struct Table {
+        uint32_t v[256];
+        Table() {
+            for (uint32_t i = 0; i < 256; i++) {
+                uint32_t c = i;
+                for (int k = 0; k < 8; k++) c = (c & 1) ? 0xedb88320u ^ (c >> 1) : c >> 1;
+                v[i] = c;
+            }
+        }
+    } table;
+    crc = ~crc;
+    for (size_t i = 0; i < n; i++) crc = table.v[(crc ^ data[i]) & 0xff] ^ (crc >> 8);
+    return ~crc;
+}
+
+inline uint32_t adler32(const uint8_t* data, size_t n) {
+    uint32_t a = 1, b = 0;
+    while (n > 0) {
+        size_t chunk = std::min<size_t>(n, 5552); // Sem estouro antes do módulo
+        for (size_t i = 0; i < chunk; i++) {
+            a += data[i];
+            b += a;
+        }
+        a %= 65521;
+        b %= 65521;
+        data += chunk;
+        n -= chunk;
+    }
+    return (b << 16) | a;
+}
+
+// Adler-32 da concatenação de dois blocos a partir dos Adler-32 de cada um
+inline uint32_t adler32_combine(uint32_t adler1, uint32_t adler2, size_t len2) {
+    const uint32_t BASE = 65521;
+    uint32_t rem = static_cast<uint32_t>(len2 % BASE);
+    uint32_t sum1 = adler1 & 0xffff;
+    uint32_t sum2 = static_cast<uint32_t>((static_cast<uint64_t>(rem) * sum1) % BASE);
+    sum1 += (adler2 & 0xffff) + BASE - 1;
+    sum2 += ((adler1 >> 16) & 0xffff) + ((adler2 >> 16) & 0xffff) + BASE - rem;
+    if (sum1 >= BASE) sum1 -= BASE;
+    if (sum1 >= BASE) sum1 -= BASE;
+    if (sum2 >= (BASE << 1)) sum2 -= (BASE << 1);
+    if (sum2 >= BASE) sum2 -= BASE;
+    return (sum2 << 16) | sum1;
+}
+
+// Bits do deflate (o primeiro bit é o menos significativo de cada byte)
+struct BitWriter {
+    std::vector<uint8_t> out;
+    uint32_t bits = 0;
+    int count = 0;
+
+    void put(uint32_t value, int n) {
+        bits |= value << count;
+        count += n;
+        while (count >= 8) {
+            out.push_back(static_cast<uint8_t>(bits));
+            bits >>= 8;
+            count -= 8;
+        }
+    }
+
+    // Códigos de Huffman vão do bit mais significativo para o menos
+    void put_code(uint32_t code, int n) {
+        uint32_t reversed = 0;
+        for (int i = 0; i < n; i++) reversed |= ((code >> i) & 1) << (n - 1 - i);
+        put(reversed, n);
+    }
+
+    void align() {
+        if (count > 0) out.push_back(static_cast<uint8_t>(bits));
+        bits = 0;
+        count = 0;
+    }
+};
+
+// Símbolo literal/comprimento na tabela de Huffman fixa (RFC 1951, 3.2.6)
+inline void put_symbol(BitWriter& w, int sym) {
+    if (sym <= 143)      w.put_code(0x30 + sym, 8);
+    else if (sym <= 255) w.put_code(0x190 + sym - 144, 9);
+    else if (sym <= 279) w.put_code(sym - 256, 7);
+    else                 w.put_code(0xc0 + sym - 280, 8);
+}
+
+inline void put_match(BitWriter& w, int length, int distance) {
+    static const int len_base[] = {3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31,
+                                   35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258};
+    static const int len_extra[] = {0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2,
+                                    3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0};
+    static const int dist_base[] = {1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193,
+                                    257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145,
+                                    8193, 12289, 16385, 24577};
+    static const int dist_extra[] = {0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6,
+                                     7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13};
+    int l = 0;
+    while (l < 28 && len_base[l + 1] <= length) l++;
+    put_symbol(w, 257 + l);
+    if (len_extra[l]) w.put(length - len_base[l], len_extra[l]);
+
+    int d = 0;
+    while (d < 29 && dist_base[d + 1] <= distance) d++;
+    w.put_code(d, 5);
+    if (dist_extra[d]) w.put(distance - dist_base[d], dist_extra[d]);
+}
+
+// Comprime 'data' em blocos deflate. Com 'last', o bloco final encerra o
+// fluxo; senão a faixa termina com um bloco stored vazio (alinhada em byte).
+inline std::vector<uint8_t> deflate_strip(const uint8_t* data, size_t n, int level, bool last) {
+    BitWriter w;
+    w.out.reserve(level == 0 ? n + n / 65535 * 5 + 10 : n / 2 + 64);
+
+    if (level <= 0) {
+        size_t pos = 0;
+        do {
+            size_t len = std::min<size_t>(n - pos, 65535);
+            bool final_block = last && pos + len == n;
+            w.put(final_block ? 1 : 0, 1);
+            w.put(0, 2);
+            w.align();
+            w.put(static_cast<uint32_t>(len), 16);
+            w.put(static_cast<uint32_t>(~len & 0xffff), 16);
+            w.out.insert(w.out.end(), data + pos, data + pos + len);
+            pos += len;
+        } while (pos < n);
+        return std::move(w.out);
+    }
+
+    static const int chain_limits[] = {0, 4, 8, 16, 32, 64, 128, 256, 512, 1024};
+    const int max_chain = chain_limits[std::min(level, 9)];
+    const bool lazy = level >= 4;
+    const int WINDOW = 32768, MIN_MATCH = 3, MAX_MATCH = 258;
+    const int HASH_BITS = 15;
+
+    std::vector<int32_t> head(1 << HASH_BITS, -1);
+    std::vector<int32_t> prev(n);
+    auto hash = [&](size_t i) {
+        uint32_t v = data[i] | (data[i + 1] << 8) | (data[i + 2] << 16);
+        return (v * 2654435761u) >> (32 - HASH_BITS);
+    };
+    auto insert = [&](size_t i) {
+        if (i + MIN_MATCH > n) return;
+        uint32_t h = hash(i);
+        prev[i] = head[h];
+        head[h] = static_cast<int32_t>(i);
+    };
+    // Maior repetição que começa em 'i' (comprimento, distância)
+    auto longest = [&](size_t i, int& best_dist) {
+        best_dist = 0;
+        if (i + MIN_MATCH > n) return 0;
+        int best = 0;
+        int limit = static_cast<int>(std::min<size_t>(MAX_MATCH, n - i));
+        int chain = max_chain;
+        for (int32_t c = head[hash(i)]; c >= 0 && chain-- > 0; c = prev[c]) {
+            if (static_cast<int>(i) - c > WINDOW) break;
+            if (data[c + best] != data[i + best]) continue;
+            int len = 0;
+            while (len < limit && data[c + len] == data[i + len]) len++;
+            if (len > best) {
+                best = len;
+                best_dist = static_cast<int>(i) - c;
+                if (len == limit) break;
+            }
+        }
+        return best >= MIN_MATCH ? best : 0;
+    };
+
+    w.put(last ? 1 : 0, 1);
+    w.put(1, 2); // Huffman fixo
+
+    size_t i = 0;
+    while (i < n) {
+        int dist;
+        int len = longest(i, dist);
+        if (!len) {
+            put_symbol(w, data[i]);
+            insert(i);
+            i++;
+            continue;
+        }
+
+        size_t first_insert = i;
+        if (lazy && len < MAX_MATCH && i + 1 < n) {
+            // Se a próxima posição tiver uma repetição maior, emite um literal antes
+            insert(i);
+            first_insert = i + 1;
+            int next_dist;
+            int next_len = longest(i + 1, next_dist);
+            if (next_len > len) {
+                put_symbol(w, data[i]);
+                i++;
+                len = next_len;
+                dist = next_dist;
+            }
+        }
+        put_match(w, len, dist);
+        for (size_t k = first_insert; k < i + len; k++) insert(k);
+        i += len;
+    }
+    put_symbol(w, 256); // Fim do bloco
+
+    if (!last) {
+        // Bloco stored vazio: alinha a faixa em byte sem encerrar o fluxo
+        w.put(0, 3);
+        w.align();
+        w.put(0x0000, 16);
+        w.put(0xffff, 16);
+    }
+    w.align();
+    return std::move(w.out);
+}
+
+// Filtro PNG de uma linha (RGB, 3 bytes por pixel): testa os cinco e fica com
+// o de menor soma dos resíduos em módulo. 'prior' = linha de cima (ou nullptr).
+inline void filter_row(const uint8_t* row, const uint8_t* prior, int row_bytes, uint8_t* out) {
+    const int bpp = 3;
+    thread_local std::vector<uint8_t> candidate;
+    candidate.resize(row_bytes);
+    long best_sum = -1;
+    for (int type = 0; type < 5; type++) {
+        long sum = 0;
+        for (int i = 0; i < row_bytes; i++) {
+            int a = i >= bpp ? row[i - bpp] : 0;
+            int b = prior ? prior[i] : 0;
+            int c = (prior && i >= bpp) ? prior[i - bpp] : 0;
+            int pred = 0;
+            switch (type) {
+                case 1: pred = a; break;
+                case 2: pred = b; break;
+                case 3: pred = (a + b) >> 1; break;
+                case 4: {
+                    int p = a + b - c;
+                    int pa = std::abs(p - a), pb = std::abs(p - b), pc = std::abs(p - c);
+                    pred = (pa <= pb && pa <= pc) ? a : (pb <= pc ? b : c);
+                    break;
+                }
+                default: break;
+            }
+            uint8_t v = static_cast<uint8_t>(row[i] - pred);
+            candidate[i] = v;
+            sum += std::abs(static_cast<int8_t>(v));
+        }
+        if (best_sum < 0 || sum < best_sum) {
+            best_sum = sum;
+            out[0] = static_cast<uint8_t>(type);
+            std::memcpy(out + 1, candidate.data(), row_bytes);
+        }
+    }
+}
+
+inline void put_be32(std::vector<uint8_t>& out, uint32_t v) {
+    for (int i = 3; i >= 0; i--) out.push_back(static_cast<uint8_t>(v >> (8 * i)));
+}
+
+// Chunk completo: tamanho, tipo, dados e CRC
+inline std::vector<uint8_t> chunk(const char* type, const std::vector<uint8_t>& data) {
+    std::vector<uint8_t> out;
+    out.reserve(data.size() + 12);
+    put_be32(out, static_cast<uint32_t>(data.size()));
+    out.insert(out.end(), type, type + 4);
+    out.insert(out.end(), data.begin(), data.end());
+    put_be32(out, crc32(out.data() + 4, data.size() + 4));
+    return out;
+}
+
+} // namespace png_detail
+
+// 'pixels' = RGB de 8 bits na ordem do framebuffer (linha 0 = topo)
+inline bool write_png(const std::string& path, int width, int height, const uint8_t* pixels,
+                      int level = 6, int strip_rows = 32) {
+    using namespace png_detail;
+    level = std::clamp(level, 0, 9);
+    strip_rows = std::max(strip_rows, 1);
+    const int row_bytes = width * 3;
+    const int strips = (height + strip_rows - 1) / strip_rows;
+
+    std::vector<std::vector<uint8_t>> compressed(strips);
+    std::vector<uint32_t> adlers(strips);
+    std::vector<size_t> lengths(strips);
+
+    #pragma omp parallel for schedule(dynamic)
+    for (int s = 0; s < strips; s++) {
+        int y0 = s * strip_rows;
+        int y1 = std::min(height, y0 + strip_rows);
+        std::vector<uint8_t> filtered(static_cast<size_t>(y1 - y0) * (row_bytes + 1));
+        for (int y = y0; y < y1; y++) {
+            const uint8_t* row = pixels + static_cast<size_t>(y) * row_bytes;
+            const uint8_t* prior = y > 0 ? row - row_bytes : nullptr;
+            filter_row(row, prior, row_bytes, &filtered[static_cast<size_t>(y - y0) * (row_bytes + 1)]);
+        }
+        adlers[s] = adler32(filtered.data(), filtered.size());
+        lengths[s] = filtered.size();
+
+        std::vector<uint8_t> data = deflate_strip(filtered.data(), filtered.size(), level, s == strips - 1);
+        compressed[s] = chunk("IDAT", data);
+    }
+
+    // Cabeçalho zlib na frente do primeiro IDAT e Adler-32 do fluxo inteiro no fim
+    uint32_t adler = adlers[0];
+    for (int s = 1; s < strips; s++) adler = adler32_combine(adler, adlers[s], lengths[s]);
+    std::vector<uint8_t> zlib_header = {0x78, static_cast<uint8_t>(level <= 1 ? 0x01 : level <= 5 ? 0x5e : level == 6 ? 0x9c : 0xda)};
+    std::vector<uint8_t> adler_bytes;
+    put_be32(adler_bytes, adler);
+
+    std::vector<uint8_t> ihdr;
+    put_be32(ihdr, static_cast<uint32_t>(width));
+    put_be32(ihdr, static_cast<uint32_t>(height));
+    ihdr.insert(ihdr.end(), {8, 2, 0, 0, 0}); // 8 bits, RGB, deflate, filtro adaptativo, sem entrelaçamento
+
+    FILE* f = std::fopen(path.c_str(), "wb");
+    if (!f) return false;
+    static const uint8_t signature[8] = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1a, '\n'};
+    bool ok = std::fwrite(signature, 1, 8, f) == 8;
+    for (const auto& c : {chunk("IHDR", ihdr), chunk("IDAT", zlib_header)}) {
+        ok = ok && std::fwrite(c.data(), 1, c.size(), f) == c.size();
+    }
+    for (const auto& c : compressed) {
+        ok = ok && std::fwrite(c.data(), 1, c.size(), f) == c.size();
+    }
+    for (const auto& c : {chunk("IDAT", adler_bytes), chunk("IEND", {})}) {
+        ok = ok && std::fwrite(c.data(), 1, c.size(), f) == c.size();
+    }
+    return (std::fclose(f) == 0) && ok;
+}
+
+#endif
@@ -0,0 +1,558 @@
+#ifndef INTEGRATOR_H
+#define INTEGRATOR_H
+
+#include <atomic>
+#include <vector>
+#include <cstdint>
+#include <utility>
+#include <algorithm>
+#include "vec3.h"
+#include "ray.h"
+#include "scene.h"
+#include "sampling.h"
+#include "stats.h"
+
+// Configurações do integrador (ajustáveis em tempo de execução, ver render_config.h)
+struct IntegratorSettings {
+    int max_depth = 8;
+    int rr_depth = 3;               // Roleta russa a partir desta profundidade
+    float rr_min_survival = 0.1f;   // Faixa da probabilidade de continuar na roleta
+    float rr_max_survival = 0.99f;
+    bool direct_light = true;       // Luz direta com MIS (false = só o rebote do BSDF acha as luzes)
+    LightSelection light_selection = LIGHT_SELECT_BVH; // Escolha da luz de cada amostra (lights.h)
+};
+
+inline IntegratorSettings integrator_settings;
+
+const Color BACKGROUND(0.05f, 0.05f, 0.05f); // Céu escuro para Cornell Box (sem mapa de ambiente)
+
+// Abertura dos diferenciais após um rebote difuso. O lóbulo difuso não tem um
+// "raio vizinho" bem definido; esta abertura (~6 graus) faz a área coberta
+// crescer com a distância, e os rebotes secundários usam menos oitavas.
+const float DIFFUSE_DIFFERENTIAL_SPREAD = 0.1f;
+
+// Contador de raios lançados pela thread atual. Cada região paralela de
+// renderização soma em 'total_rays_cast', ao terminar, o que cada thread lançou nela.
+inline thread_local unsigned long long rays_cast = 0;
+inline std::atomic<unsigned long long> total_rays_cast{0};
+
+// Interseção dos raios diferenciais com o plano tangente no ponto atingido:
+// dá a variação do ponto entre raios vizinhos e a largura da área coberta.
+inline void compute_differentials(const Ray& r, HitRecord& rec) {
+    rec.dpdx = Vec3(0, 0, 0);
+    rec.dpdy = Vec3(0, 0, 0);
+    rec.footprint = 0.0f;
+    if (!r.has_differentials) return;
+
+    float dx = Vec3::dot(rec.normal, r.rx_direction);
+    float dy = Vec3::dot(rec.normal, r.ry_direction);
+    if (std::abs(dx) < 1e-8f || std::abs(dy) < 1e-8f) return;
+
+    float plane_d = Vec3::dot(rec.normal, rec.p);
+    float tx = (plane_d - Vec3::dot(rec.normal, r.rx_origin)) / dx;
+    float ty = (plane_d - Vec3::dot(rec.normal, r.ry_origin)) / dy;
+    rec.dpdx = r.rx_origin + r.rx_direction * tx - rec.p;
+    rec.dpdy = r.ry_origin + r.ry_direction * ty - rec.p;
+    rec.footprint = std::sqrt(std::max(rec.dpdx.length_squared(), rec.dpdy.length_squared()));
+}
+
+// VARIANTE 9: Aplicação de Textura Sólida
+// Se o objeto foi marcado como TEXTURED (ex: caixas do OBJ), aplicamos a textura.
+// Fica fora de scatter_path para que o estágio em lote avalie vários pontos de uma vez.
+inline void apply_texture(HitRecord& rec, const Scene& scene) {
+    if (rec.mat_type == TEXTURED) {
+        // Cache pré-amostrado quando existir; senão a textura ao vivo (scene.texture_type)
+        if (const BakedTexture3D* bake = scene.baked_texture(rec.object_id)) {
+            PT_STAT_INC(baked_lookups);
+            rec.albedo = bake->lookup(rec.p);
+        } else {
+            PT_STAT_INC(textured_evals);
+            rec.albedo = scene.solid_tex.eval(scene.texture_type, rec.p, rec.footprint);
+        }
+    }
+}
+
+// ----------------------------------------------------------------------------
+// Luz direta (next event estimation) com MIS
+// ----------------------------------------------------------------------------
+// Em cada vértice difuso um ponto é sorteado nas luzes de área (scene.lights)
+// ou uma direção no mapa de ambiente (scene.environment) e ligado por um raio
+// de sombra. O mesmo caminho de luz também pode ser achado pelo rebote do
+// BSDF; as duas estimativas são somadas com os pesos da heurística da
+// potência, então luzes pequenas (onde o rebote quase nunca acerta) e grandes
+// (onde o sorteio na luz erra muito) convergem bem.
+
+// Peso da estratégia de densidade 'a' contra a de densidade 'b'
+inline float power_heuristic(float a, float b) {
+    a *= a;
+    b *= b;
+    return a / (a + b);
+}
+
+// Último rebote do caminho, para o peso MIS quando ele acerta uma luz: a
+// densidade do BSDF e a normal do vértice de onde saiu (a escolha da luz pela
+// hierarquia depende do ponto e da normal; o ponto é a origem do raio)
+struct LastBounce {
+    float pdf = 0.0f;   // Ângulo sólido; 0 = câmera ou metal, sem MIS
+    Vec3 normal;
+};
+
+// Probabilidade de a luz direta sortear o mapa de ambiente em vez das luzes
+// de área: metade quando há os dois (como o pbrt faz com as luzes infinitas)
+inline float environment_selection(const Scene& scene) {
+    if (!scene.environment.loaded()) return 0.0f;
+    return scene.lights.empty() ? 1.0f : 0.5f;
+}
+
+// Luz direta do mapa de ambiente (escolhido com probabilidade 'selection')
+inline Color direct_environment(const Scene& scene, const HitRecord& rec, float selection, float u1, float u2) {
+    float pdf_env;
+    Vec3 wi = scene.environment.sample(u1, u2, pdf_env);
+    float cos_surface = Vec3::dot(rec.normal, wi);
+    if (pdf_env <= 0.0f || cos_surface <= 0.0f) return Color(0, 0, 0);
+
+    rays_cast++;
+    PT_STAT_INC(shadow_rays);
+    if (scene.occluded(Ray(rec.p, wi), 0.001f, 1e30f)) {
+        PT_STAT_INC(shadow_blocked);
+        return Color(0, 0, 0);
+    }
+
+    float pdf_light = selection * pdf_env;
+    float pdf_bsdf = cos_surface / static_cast<float>(M_PI);
+    float weight = power_heuristic(pdf_light, pdf_bsdf);
+    return rec.albedo * scene.environment.eval(wi) * (pdf_bsdf * weight / pdf_light);
+}
+
+// Contribuição da luz direta num ponto difuso (sem o throughput), já com o
+// peso MIS contra a amostragem cosseno do BSDF
+inline Color direct_light(const Scene& scene, const HitRecord& rec) {
+    float u_light = random_float();
+    float u1 = random_float();
+    float u2 = random_float();
+
+    // Ambiente ou luzes de área; 'u_light' é reaproveitado na escolha da luz
+    float env_selection = environment_selection(scene);
+    if (u_light < env_selection) return direct_environment(scene, rec, env_selection, u1, u2);
+    u_light = std::min((u_light - env_selection) / (1.0f - env_selection), 0.99999994f);
+
+    LightSample light;
+    if (!scene.lights.sample(integrator_settings.light_selection, rec.p, rec.normal, u_light, u1, u2, light)) {
+        return Color(0, 0, 0);
+    }
+
+    Vec3 to_light = light.p - rec.p;
+    float dist2 = to_light.length_squared();
+    if (dist2 <= 1e-12f) return Color(0, 0, 0);
+    float dist = std::sqrt(dist2);
+    Vec3 wi = to_light / dist;
+    float cos_surface = Vec3::dot(rec.normal, wi);
+    float cos_light = -Vec3::dot(light.normal, wi);
+    if (cos_surface <= 0.0f || cos_light <= 0.0f) return Color(0, 0, 0);
+
+    rays_cast++;
+    PT_STAT_INC(shadow_rays);
+    if (scene.occluded(Ray(rec.p, wi), 0.001f, dist - 0.001f)) {
+        PT_STAT_INC(shadow_blocked);
+        return Color(0, 0, 0);
+    }
+
+    float pdf_light = (1.0f - env_selection) * light.pdf_area * dist2 / cos_light;  // Por ângulo sólido
+    float pdf_bsdf = cos_surface / static_cast<float>(M_PI);
+    float weight = power_heuristic(pdf_light, pdf_bsdf);
+    // BSDF lambertiano: albedo / pi
+    return rec.albedo * light.emission * (pdf_bsdf * weight / pdf_light);
+}
+
+// Radiância de um raio que saiu da cena: o mapa de ambiente, com o peso MIS
+// contra a luz direta do vértice anterior, ou o fundo constante
+inline Color escaped_radiance(const Scene& scene, const Ray& r, const LastBounce& last) {
+    if (!scene.environment.loaded()) return BACKGROUND;
+    Vec3 dir = r.direction.normalized();
+    Color env = scene.environment.eval(dir);
+    if (last.pdf > 0.0f && integrator_settings.direct_light) {
+        float pdf_light = environment_selection(scene) * scene.environment.pdf(dir);
+        env = env * power_heuristic(last.pdf, pdf_light);
+    }
+    return env;
+}
+
+// Processa um vértice do caminho (já texturizado): soma a emissão e a luz
+// direta em 'radiance', atualiza o 'throughput' e gera o raio espalhado.
+// 'last' entra com o rebote do vértice anterior que gerou 'r' e sai com o do
+// raio espalhado. Retorna false se o caminho terminou.
+inline bool scatter_path(const Scene& scene, const Ray& r, HitRecord& rec, int depth,
+                         Color& throughput, Color& radiance, Ray& scattered, LastBounce& last) {
+    // 1. Se acertou uma luz (material emissivo), soma a cor da luz. As luzes
+    // emitem só pela frente e não refletem.
+    if (rec.emission.length() > 0.0f) {
+        if (rec.front_face) {
+            float weight = 1.0f;
+            if (last.pdf > 0.0f && rec.light >= 0 && integrator_settings.direct_light) {
+                // A luz direta do vértice anterior também podia ter achado este ponto
+                float length = r.direction.length();
+                float dist = rec.t * length;
+                float cos_light = -Vec3::dot(rec.normal, r.direction) / length;
+                float pdf_light = (1.0f - environment_selection(scene)) *
+                                  scene.lights.pdf_area(integrator_settings.light_selection, rec.light, r.origin,
+                                                        last.normal) * dist * dist / std::max(cos_light, 1e-6f);
+                weight = power_heuristic(last.pdf, pdf_light);
+            }
+            radiance = radiance + throughput * rec.emission * weight;
+        }
+        PT_STAT_INC(emitter_hits);
+        return false;
+    }
+
+    const bool metal = rec.mat_type == METAL;
+
+    // 2. Luz direta nos difusos (o metal, quase especular, fica com o rebote).
+    // No último vértice o rebote não seria traçado, então a ligação também não.
+    if (!metal && integrator_settings.direct_light && (!scene.lights.empty() || scene.environment.loaded()) &&
+        depth + 1 < integrator_settings.max_depth) {
+        radiance = radiance + throughput * direct_light(scene, rec);
+    }
+
+    // 3. Otimização: Roleta Russa (Russian Roulette)
+    // Encerra caminhos aleatoriamente para economizar tempo em profundidades altas
+    if (depth >= integrator_settings.rr_depth) {
+        float p = std::max({rec.albedo.x, rec.albedo.y, rec.albedo.z});
+        p = std::clamp(p, integrator_settings.rr_min_survival,
+                       integrator_settings.rr_max_survival); // Probabilidade de continuar
+
+        if (random_float() > p) {
+            PT_STAT_INC(rr_terminations);
+            return false; // Caminho "morreu"
+        }
+        rec.albedo = rec.albedo / p; // Compensa a energia dos que sobreviveram
+    }
+
+    // 4. Cálculo do Espalhamento (Scattering) baseado no Material
+    Vec3 scatter_direction;
+
+    if (metal) {
+        // --- MATERIAL METÁLICO (Especular) ---
+        Vec3 reflected = Vec3::reflect(r.direction.normalized(), rec.normal);
+
+        // Adiciona rugosidade usando o parâmetro 'fuzz' do objeto
+        scatter_direction = (reflected + rec.fuzz * cosine_sample_hemisphere(rec.normal)).normalized();
+
+        // Se o raio refletido for para dentro da superfície, ele é absorvido
+        if (Vec3::dot(scatter_direction, rec.normal) <= 0.0f) {
+            PT_STAT_INC(metal_absorbed);
+            return false;
+        }
+    } else {
+        // --- MATERIAL DIFUSO / TEXTURIZADO (Lambertiano) ---
+        // Amostragem cosseno para iluminação global suave
+        scatter_direction = cosine_sample_hemisphere(rec.normal);
+    }
+    last.pdf = metal ? 0.0f : std::max(Vec3::dot(rec.normal, scatter_direction), 0.0f) / static_cast<float>(M_PI);
+    last.normal = rec.normal;
+
+    // Equação de Renderização simplificada: Cor = Albedo * Luz Recebida
+    scattered = Ray(rec.p, scatter_direction);
+    throughput = throughput * rec.albedo;
+
+    // Propaga os diferenciais: reflexão especular dos raios vizinhos no metal,
+    // abertura fixa ao redor da direção amostrada nos difusos
+    if (rec.footprint > 0.0f) {
+        scattered.has_differentials = true;
+        scattered.rx_origin = rec.p + rec.dpdx;
+        scattered.ry_origin = rec.p + rec.dpdy;
+        if (metal) {
+            scattered.rx_direction = Vec3::reflect(r.rx_direction, rec.normal);
+            scattered.ry_direction = Vec3::reflect(r.ry_direction, rec.normal);
+        } else {
+            // dpdx/dpdy estão no plano tangente: servem de eixos para a abertura
+            float k = DIFFUSE_DIFFERENTIAL_SPREAD / rec.footprint;
+            scattered.rx_direction = scatter_direction + rec.dpdx * k;
+            scattered.ry_direction = scatter_direction + rec.dpdy * k;
+        }
+    }
+    return true;
+}
+
+// ----------------------------------------------------------------------------
+// Buffers auxiliares (AOVs) do primeiro acerto, usados pelo denoiser
+// ----------------------------------------------------------------------------
+
+struct FirstHit {
+    Color albedo;       // Albedo já texturizado (1 nas luzes, fundo nos raios perdidos)
+    Vec3 normal;        // Normal voltada para a câmera (0 nos raios perdidos)
+    float depth = 0.0f; // Distância até a câmera (0 nos raios perdidos)
+};
+
+inline FirstHit first_hit_aov(const HitRecord& rec) {
+    FirstHit first;
+    // As luzes não são demoduladas pelo albedo
+    first.albedo = rec.emission.length() > 0.0f ? Color(1, 1, 1) : rec.albedo;
+    first.normal = rec.normal;
+    first.depth = rec.t;
+    return first;
+}
+
+inline FirstHit first_hit_miss() {
+    FirstHit first;
+    first.albedo = BACKGROUND;
+    return first;
+}
+
+// Somas por pixel das AOVs (ponteiros já posicionados no início do bloco)
+struct AovTarget {
+    Color* albedo = nullptr;
+    Vec3* normal = nullptr;
+    float* depth = nullptr;
+    float* lum_sq = nullptr;    // Soma da luminância² de cada amostra (variância)
+    uint32_t* rays = nullptr;   // Raios lançados por pixel (mapa de custo, opcional)
+
+    void add_first_hit(int pixel, const FirstHit& first) const {
+        albedo[pixel] = albedo[pixel] + first.albedo;
+        normal[pixel] = normal[pixel] + first.normal;
+        depth[pixel] += first.depth;
+    }
+
+    void add_sample(int pixel, const Color& radiance) const {
+        float l = luminance(radiance);
+        lum_sq[pixel] += l * l;
+    }
+};
+
+// Path tracing integrador. Com 'first', devolve as AOVs do primeiro acerto.
+inline Color trace(const Ray& r, const Scene& scene, int depth, FirstHit* first = nullptr) {
+    Color throughput(1, 1, 1);
+    Color radiance(0, 0, 0);
+    Ray ray = r;
+    LastBounce last;
+    if (first) *first = first_hit_miss();
+    PT_STATS_ONLY(int vertices = 0;)
+
+    // Limite de recursão (profundidade máxima)
+    const int max_depth = integrator_settings.max_depth;
+    for (int start = depth; depth < max_depth; depth++) {
+        HitRecord rec;
+        rays_cast++;
+        PT_STAT_RAY(depth);
+        PT_STATS_ONLY(vertices++;)
+        bool hit;
+        {
+            PT_STAT_TIMER(intersect_ns);
+            hit = scene.hit(ray, 0.001f, 1e30f, rec);
+            if (hit) compute_differentials(ray, rec);
+        }
+        if (!hit) {
+            radiance = radiance + throughput * escaped_radiance(scene, ray, last);
+            break;
+        }
+        PT_STAT_TIMER(shade_ns);
+        apply_texture(rec, scene);
+        if (first && depth == start) *first = first_hit_aov(rec);
+        if (!scatter_path(scene, ray, rec, depth, throughput, radiance, ray, last)) {
+            break;
+        }
+    }
+
+    PT_STAT_PATH(vertices);
+    return radiance;
+}
+
+// ----------------------------------------------------------------------------
+// Reordenação de raios secundários por coerência
+// ----------------------------------------------------------------------------
+// Os rebotes difusos saem em direções aleatórias e percorrem a cena em ordem
+// arbitrária. O estágio abaixo processa os caminhos em lotes (em largura):
+// a cada profundidade todos os raios vivos do lote são ordenados por uma
+// chave barata (código de Morton da origem + octante da direção) antes de
+// serem lançados, de modo que raios vizinhos acessem os mesmos objetos.
+
+struct PathState {
+    Ray ray;
+    Color throughput;
+    Color radiance;     // Radiância acumulada por este caminho
+    int pixel;          // Índice do pixel no bloco que originou o caminho
+    LastBounce last;    // Último rebote (ver scatter_path)
+};
+
+// Espalha os 10 bits menos significativos de 'v' para cada terceiro bit
+inline uint32_t expand_bits_10(uint32_t v) {
+    v &= 0x3ff;
+    v = (v | (v << 16)) & 0x030000ff;
+    v = (v | (v << 8))  & 0x0300f00f;
+    v = (v | (v << 4))  & 0x030c30c3;
+    v = (v | (v << 2))  & 0x09249249;
+    return v;
+}
+
+// Chave de ordenação: 30 bits de Morton da origem (10 por eixo, quantizados na
+// caixa da cena) seguidos de 3 bits com o sinal de cada componente da direção
+inline uint64_t ray_sort_key(const Ray& r, const Point3& bmin, const Vec3& inv_extent) {
+    auto quantize = [](float v) {
+        return static_cast<uint32_t>(std::clamp(v, 0.0f, 1.0f) * 1023.0f);
+    };
+    uint32_t qx = quantize((r.origin.x - bmin.x) * inv_extent.x);
+    uint32_t qy = quantize((r.origin.y - bmin.y) * inv_extent.y);
+    uint32_t qz = quantize((r.origin.z - bmin.z) * inv_extent.z);
+    uint32_t morton = (expand_bits_10(qx) << 2) | (expand_bits_10(qy) << 1) | expand_bits_10(qz);
+
+    uint32_t octant = (r.direction.x < 0.0f ? 4u : 0u) |
+                      (r.direction.y < 0.0f ? 2u : 0u) |
+                      (r.direction.z < 0.0f ? 1u : 0u);
+    return (static_cast<uint64_t>(morton) << 3) | octant;
+}
+
+// Buffers do integrador em lote, thread_local: cada thread reaproveita os
+// seus entre blocos e entre variantes
+struct BatchBuffers {
+    std::vector<PathState> paths;
+    std::vector<PathState> next_paths;
+    std::vector<PathState> sorted_paths;
+    std::vector<std::pair<uint64_t, uint32_t>> keys;
+    std::vector<HitRecord> recs;
+    std::vector<uint8_t> hit_flags;
+    std::vector<uint32_t> textured;
+    std::vector<Point3> tex_points;
+    std::vector<Color> tex_colors;
+    std::vector<float> tex_footprints;
+};
+
+inline BatchBuffers& batch_buffers() {
+    thread_local BatchBuffers buffers;
+    return buffers;
+}
+
+// Traça 'spp' amostras para cada um dos 'num_pixels' pixels de um bloco, em
+// lotes de 'batch_spp' amostras por pixel. 'gen_ray(i)' gera o raio primário do
+// pixel i. As somas (não normalizadas) são acumuladas em 'out' e, se 'aov'
+// tiver buffers, também as AOVs do primeiro acerto e a luminância².
+// Cada profundidade roda em três fases sobre o lote inteiro: interseção,
+// texturas em lote (8 pontos por chamada de ruído) e espalhamento.
+// Com 'sort_rays', os raios secundários são ordenados antes da interseção.
+template <typename RayGen>
+void trace_batched(const Scene& scene, int num_pixels, int spp, int batch_spp, bool sort_rays,
+                   RayGen gen_ray, Color* out, const AovTarget& aov = AovTarget()) {
+    BatchBuffers& buffers = batch_buffers();
+    auto& paths = buffers.paths;
+    auto& next_paths = buffers.next_paths;
+    auto& sorted_paths = buffers.sorted_paths;
+    auto& keys = buffers.keys;
+    auto& recs = buffers.recs;
+    auto& hit_flags = buffers.hit_flags;
+    auto& textured = buffers.textured;
+    auto& tex_points = buffers.tex_points;
+    auto& tex_colors = buffers.tex_colors;
+    auto& tex_footprints = buffers.tex_footprints;
+
+    Vec3 extent = scene.bounds_max - scene.bounds_min;
+    Vec3 inv_extent(1.0f / std::max(extent.x, 1e-6f),
+                    1.0f / std::max(extent.y, 1e-6f),
+                    1.0f / std::max(extent.z, 1e-6f));
+
+    for (int s0 = 0; s0 < spp; s0 += batch_spp) {
+        int batch = std::min(batch_spp, spp - s0);
+
+        // Raios primários já são coerentes: saem na ordem dos pixels
+        paths.clear();
+        for (int i = 0; i < num_pixels; i++) {
+            for (int s = 0; s < batch; s++) {
+                paths.push_back({gen_ray(i), Color(1, 1, 1), Color(0, 0, 0), i, LastBounce()});
+            }
+        }
+
+        const int max_depth = integrator_settings.max_depth;
+        for (int depth = 0; depth < max_depth && !paths.empty(); depth++) {
+            // Ordena os raios secundários
+            if (sort_rays && depth > 0) {
+                PT_STAT_TIMER(sort_ns);
+                keys.resize(paths.size());
+                for (size_t i = 0; i < paths.size(); i++) {
+                    keys[i] = {ray_sort_key(paths[i].ray, scene.bounds_min, inv_extent), static_cast<uint32_t>(i)};
+                }
+                std::sort(keys.begin(), keys.end());
+
+                sorted_paths.resize(paths.size());
+                for (size_t i = 0; i < keys.size(); i++) {
+                    sorted_paths[i] = paths[keys[i].second];
+                }
+                paths.swap(sorted_paths);
+            }
+
+            // 1. Interseção
+            recs.resize(paths.size());
+            hit_flags.resize(paths.size());
+            textured.clear();
+            PT_STATS_ONLY(StatTimer intersect_timer(render_stats.intersect_ns);)
+            for (size_t i = 0; i < paths.size(); i++) {
+                rays_cast++;
+                PT_STAT_RAY(depth);
+                if (aov.rays) aov.rays[paths[i].pixel]++;
+                hit_flags[i] = scene.hit(paths[i].ray, 0.001f, 1e30f, recs[i]);
+                if (hit_flags[i]) {
+                    compute_differentials(paths[i].ray, recs[i]);
+                }
+                if (hit_flags[i] && recs[i].mat_type == TEXTURED) {
+                    // Objetos com cache são resolvidos aqui; os demais vão para o lote
+                    if (const BakedTexture3D* bake = scene.baked_texture(recs[i].object_id)) {
+                        PT_STAT_INC(baked_lookups);
+                        recs[i].albedo = bake->lookup(recs[i].p);
+                    } else {
+                        textured.push_back(static_cast<uint32_t>(i));
+                    }
+                }
+            }
+
+            PT_STATS_ONLY(intersect_timer.stop();)
+
+            // 2. Texturas sólidas em lote
+            PT_STATS_ONLY(StatTimer shade_timer(render_stats.shade_ns);)
+            if (!textured.empty()) {
+                PT_STAT_ADD(textured_evals, textured.size());
+                tex_points.resize(textured.size());
+                tex_colors.resize(textured.size());
+                tex_footprints.resize(textured.size());
+                for (size_t k = 0; k < textured.size(); k++) {
+                    tex_points[k] = recs[textured[k]].p;
+                    tex_footprints[k] = recs[textured[k]].footprint;
+                }
+                scene.solid_tex.eval_batch(scene.texture_type, tex_points.data(), tex_colors.data(),
+                                           static_cast<int>(textured.size()), tex_footprints.data());
+                for (size_t k = 0; k < textured.size(); k++) {
+                    recs[textured[k]].albedo = tex_colors[k];
+                }
+            }
+
+            // AOVs do primeiro acerto (já com a textura)
+            if (aov.albedo && depth == 0) {
+                for (size_t i = 0; i < paths.size(); i++) {
+                    aov.add_first_hit(paths[i].pixel, hit_flags[i] ? first_hit_aov(recs[i]) : first_hit_miss());
+                }
+            }
+
+            // 3. Espalhamento
+            next_paths.clear();
+            for (size_t i = 0; i < paths.size(); i++) {
+                PathState& path = paths[i];
+                bool alive = false;
+                if (!hit_flags[i]) {
+                    path.radiance = path.radiance + path.throughput * escaped_radiance(scene, path.ray, path.last);
+                } else {
+                    Ray scattered;
+                    alive = scatter_path(scene, path.ray, recs[i], depth, path.throughput, path.radiance,
+                                         scattered, path.last);
+                    path.ray = scattered;
+                }
+
+                // Caminho encerrado (ou na profundidade máxima): entrega a amostra
+                if (alive && depth + 1 < max_depth) {
+                    next_paths.push_back(path);
+                } else {
+                    out[path.pixel] = out[path.pixel] + path.radiance;
+                    PT_STAT_PATH(depth + 1);
+                    if (aov.lum_sq) aov.add_sample(path.pixel, path.radiance);
+                }
+            }
+            paths.swap(next_paths);
+        }
+    }
+}
+
+#endif
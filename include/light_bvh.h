@@ -0,0 +1,336 @@
+#ifndef LIGHT_BVH_H
+#define LIGHT_BVH_H
+
+#include <cmath>
+#include <vector>
+#include <cstdint>
+#include <algorithm>
+#include "vec3.h"
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+// Hierarquia de luzes (Conty e Kulla, "Importance Sampling of Many Lights
+// with Adaptive Tree Splitting"; a mesma do pbrt-v4): uma BVH sobre as luzes
+// em que cada nó guarda a região das suas luzes, a potência e um cone que
+// limita as normais de emissão. Num ponto sombreado, a importância de um nó é uma cota superior
+// da contribuição das suas luzes (potência / distância², reduzida pelos
+// ângulos entre o ponto, o cone e a normal da superfície). O sorteio desce da
+// raiz escolhendo um filho com probabilidade proporcional à importância: o
+// custo é logarítmico no número de luzes e as luzes que não iluminam o ponto
+// (de costas, atrás da superfície ou longe) quase nunca recebem raios.
+
+// Caixa, cone de normais e potência de uma luz ou de um grupo de luzes.
+// O cone tem eixo 'axis' e meia-abertura theta_o (cos_o); cada normal emite
+// até theta_e (cos_e) dela. Triângulo: theta_o = 0, theta_e = 90 graus;
+// esfera: theta_o = 180 graus.
+struct LightBounds {
+    Point3 lo = Point3(1e30f, 1e30f, 1e30f);
+    Point3 hi = Point3(-1e30f, -1e30f, -1e30f);
+    Vec3 axis = Vec3(0, 0, 1);
+    float cos_o = 1.0f;
+    float cos_e = 1.0f;
+    float power = 0.0f;
+
+    Point3 center() const { return (lo + hi) * 0.5f; }
+
+    // cos(max(0, a - b)) e sin(max(0, a - b)) pelos senos e cossenos de a e b
+    static float cos_sub_clamped(float sin_a, float cos_a, float sin_b, float cos_b) {
+        if (cos_a > cos_b) return 1.0f;
+        return cos_a * cos_b + sin_a * sin_b;
+    }
+    static float sin_sub_clamped(float sin_a, float cos_a, float sin_b, float cos_b) {
+        if (cos_a > cos_b) return 0.0f;
+        return sin_a * cos_b - cos_a * sin_b;
+    }
+    static float safe_sqrt(float v) { return std::sqrt(std::max(v, 0.0f)); }
+
+    // Gira 'v' de 'angle' em torno do eixo unitário 'k' (Rodrigues)
+    static Vec3 rotate(const Vec3& v, const Vec3& k, float angle) {
+        float c = std::cos(angle), s = std::sin(angle);
+        return v * c + Vec3::cross(k, v) * s + k * (Vec3::dot(k, v) * (1.0f - c));
+    }
+
+    // União de dois grupos: caixa e potência somadas, menor cone que contém os dois
+    static LightBounds merge(const LightBounds& a, const LightBounds& b) {
+        if (a.power <= 0.0f) return b;
+        if (b.power <= 0.0f) return a;
+        LightBounds u;
+        u.lo = Point3(std::min(a.lo.x, b.lo.x), std::min(a.lo.y, b.lo.y), std::min(a.lo.z, b.lo.z));
+        u.hi = Point3(std::max(a.hi.x, b.hi.x), std::max(a.hi.y, b.hi.y), std::max(a.hi.z, b.hi.z));
+        u.power = a.power + b.power;
+        u.cos_e = std::min(a.cos_e, b.cos_e);
+
+        const float pi = static_cast<float>(M_PI);
+        float theta_a = std::acos(std::clamp(a.cos_o, -1.0f, 1.0f));
+        float theta_b = std::acos(std::clamp(b.cos_o, -1.0f, 1.0f));
+        float theta_d = std::acos(std::clamp(Vec3::dot(a.axis, b.axis), -1.0f, 1.0f));
+        if (std::min(theta_d + theta_b, pi) <= theta_a) {
+            u.axis = a.axis;
+            u.cos_o = a.cos_o;
+        } else if (std::min(theta_d + theta_a, pi) <= theta_b) {
+            u.axis = b.axis;
+            u.cos_o = b.cos_o;
+        } else {
+            float theta_o = (theta_a + theta_d + theta_b) * 0.5f;
+            Vec3 k = Vec3::cross(a.axis, b.axis);
+            if (theta_o >= pi || k.length_squared() < 1e-12f) {
+                u.axis = a.axis;
+                u.cos_o = -1.0f; // Todas as direções
+            } else {
+                u.axis = rotate(a.axis, k.normalized(), theta_o - theta_a).normalized();
+                u.cos_o = std::cos(theta_o);
+            }
+        }
+        return u;
+    }
+
+    // Custo de superfície e orientação (SAOH) do grupo, para o build
+    float cost() const {
+        if (power <= 0.0f) return 0.0f;
+        const float pi = static_cast<float>(M_PI);
+        float theta_o = std::acos(std::clamp(cos_o, -1.0f, 1.0f));
+        float theta_e = std::acos(std::clamp(cos_e, -1.0f, 1.0f));
+        float theta_w = std::min(theta_o + theta_e, pi);
+        float sin_o = safe_sqrt(1.0f - cos_o * cos_o);
+        float m_omega = 2.0f * pi * (1.0f - cos_o) +
+                        pi / 2.0f * (2.0f * theta_w * sin_o - std::cos(theta_o - 2.0f * theta_w) -
+                                     2.0f * theta_o * sin_o + cos_o);
+        Vec3 d = hi - lo;
+        float area = 2.0f * (d.x * d.y + d.y * d.z + d.z * d.x);
+        return power * m_omega * std::max(area, 1e-12f);
+    }
+};
+
+// Nó da hierarquia: o grupo já reduzido ao que a importância usa (esfera
+// envolvente no lugar da caixa, senos pré-calculados)
+struct LightNode {
+    Point3 center;
+    float radius2;      // Raio² da esfera envolvente da caixa
+    Vec3 axis;
+    float min_d2;       // Piso da distância² (evita explodir perto do grupo)
+    float cos_o, sin_o, cos_e;
+    float power;
+    int child = -1;     // Interno: filhos em 'child' e 'child' + 1 (-1 = folha)
+    int light = -1;     // Folha: índice da luz
+
+    bool is_leaf() const { return child < 0; }
+
+    void set_bounds(const LightBounds& b) {
+        Vec3 diagonal = b.hi - b.lo;
+        center = b.center();
+        radius2 = diagonal.length_squared() * 0.25f;
+        min_d2 = diagonal.length() * 0.5f;
+        axis = b.axis;
+        cos_o = b.cos_o;
+        sin_o = LightBounds::safe_sqrt(1.0f - b.cos_o * b.cos_o);
+        cos_e = b.cos_e;
+        power = b.power;
+    }
+
+    // Cota da contribuição no ponto 'p' de normal 'n' (lado que reflete)
+    float importance(const Point3& p, const Vec3& n) const {
+        if (power <= 0.0f) return 0.0f;
+        Vec3 d = p - center;
+        float dist2 = d.length_squared();
+        float d2 = std::max(dist2, min_d2);
+
+        // Ponto dentro da esfera envolvente: qualquer direção é possível
+        if (dist2 <= radius2) return power / d2;
+
+        // Ângulo entre o eixo do cone e a direção da luz para o ponto, menos
+        // a abertura do cone e o ângulo subentendido pela esfera envolvente
+        Vec3 wi = d / std::sqrt(dist2);
+        float cos_w = Vec3::dot(axis, wi);
+        float sin_w = LightBounds::safe_sqrt(1.0f - cos_w * cos_w);
+        float sin_b2 = radius2 / dist2;
+        float cos_b = LightBounds::safe_sqrt(1.0f - sin_b2);
+        float sin_b = std::sqrt(sin_b2);
+
+        float cos_x = LightBounds::cos_sub_clamped(sin_w, cos_w, sin_o, cos_o);
+        float sin_x = LightBounds::sin_sub_clamped(sin_w, cos_w, sin_o, cos_o);
+        float cos_p = LightBounds::cos_sub_clamped(sin_x, cos_x, sin_b, cos_b);
+        if (cos_p <= cos_e) return 0.0f;
+        float value = power * cos_p / d2;
+
+        // Lado da superfície: a luz precisa estar acima do plano tangente
+        float cos_i = -Vec3::dot(wi, n);
+        float sin_i = LightBounds::safe_sqrt(1.0f - cos_i * cos_i);
+        value *= LightBounds::cos_sub_clamped(sin_i, cos_i, sin_b, cos_b);
+        return std::max(value, 0.0f);
+    }
+};
+
+class LightBVH {
+public:
+    static constexpr int BUCKETS = 12;
+    static constexpr int MAX_DEPTH = 64;    // Bits do caminho de cada luz (folhas nunca passam disto)
+
+    std::vector<LightNode> nodes;           // Raiz em nodes[0]
+
+    bool empty() const { return nodes.empty(); }
+
+    void build(const std::vector<LightBounds>& lights) {
+        nodes.clear();
+        trail_.assign(lights.size(), 0);
+        if (lights.empty()) return;
+        std::vector<int> order(lights.size());
+        for (size_t i = 0; i < lights.size(); i++) order[i] = static_cast<int>(i);
+        nodes.reserve(2 * lights.size());
+        nodes.emplace_back();
+        split(0, order, 0, static_cast<int>(order.size()), 0, 0, lights);
+    }
+
+    // Sorteia uma luz para o ponto 'p' de normal 'n'. 'pmf' recebe a
+    // probabilidade; -1 se nenhuma luz pode iluminar o ponto.
+    int sample(const Point3& p, const Vec3& n, float u, float& pmf) const {
+        pmf = 0.0f;
+        if (nodes.empty()) return -1;
+        float prob = 1.0f;
+        int index = 0;
+        while (!nodes[index].is_leaf()) {
+            const LightNode& node = nodes[index];
+            float i0 = nodes[node.child].importance(p, n);
+            float i1 = nodes[node.child + 1].importance(p, n);
+            if (i0 <= 0.0f && i1 <= 0.0f) return -1;
+            float p0 = i0 / (i0 + i1);
+            // Reaproveita 'u' reescalado para o próximo nível
+            if (u < p0) {
+                index = node.child;
+                u = std::min(u / p0, 0.99999994f);
+                prob *= p0;
+            } else {
+                float p1 = i1 / (i0 + i1);  // Igual ao de pmf()
+                index = node.child + 1;
+                u = std::min((u - p0) / p1, 0.99999994f);
+                prob *= p1;
+            }
+        }
+        // Com uma luz só a raiz é a folha e ninguém olhou a importância dela
+        if (index == 0 && nodes[0].importance(p, n) <= 0.0f) return -1;
+        pmf = prob;
+        return nodes[index].light;
+    }
+
+    // Probabilidade de sample() devolver 'light' no ponto 'p' de normal 'n'
+    // (refaz as escolhas do caminho da raiz até a folha da luz)
+    float pmf(int light, const Point3& p, const Vec3& n) const {
+        if (light < 0 || light >= static_cast<int>(trail_.size()) || nodes.empty()) return 0.0f;
+        uint64_t trail = trail_[light];
+        float prob = 1.0f;
+        int index = 0;
+        while (!nodes[index].is_leaf()) {
+            const LightNode& node = nodes[index];
+            float i0 = nodes[node.child].importance(p, n);
+            float i1 = nodes[node.child + 1].importance(p, n);
+            if (i0 <= 0.0f && i1 <= 0.0f) return 0.0f;
+            int side = static_cast<int>(trail & 1);
+            prob *= (side ? i1 : i0) / (i0 + i1);
+            index = node.child + side;
+            trail >>= 1;
+        }
+        // Mesma regra de sample() para a raiz folha
+        if (index == 0 && nodes[0].importance(p, n) <= 0.0f) return 0.0f;
+        return prob;
+    }
+
+private:
+    std::vector<uint64_t> trail_;   // Por luz: escolhas (bit 0 = primeiro nível) até a sua folha
+
+    void split(int index, std::vector<int>& order, int begin, int end, int depth, uint64_t trail,
+               const std::vector<LightBounds>& lights) {
+        if (end - begin == 1) {
+            nodes[index].set_bounds(lights[order[begin]]);
+            nodes[index].light = order[begin];
+            trail_[order[begin]] = trail;
+            return;
+        }
+
+        LightBounds bounds;
+        for (int i = begin; i < end; i++) bounds = LightBounds::merge(bounds, lights[order[i]]);
+        int mid = choose_split(order, begin, end, bounds, depth, lights);
+
+        int child = static_cast<int>(nodes.size());
+        nodes.emplace_back();
+        nodes.emplace_back();
+        nodes[index].child = child;
+        split(child, order, begin, mid, depth + 1, trail, lights);
+        split(child + 1, order, mid, end, depth + 1, trail | (uint64_t(1) << depth), lights);
+        nodes[index].set_bounds(bounds);
+    }
+
+    // Divide [begin, end) pelo SAOH em BUCKETS intervalos dos centros, no
+    // melhor dos três eixos; sem divisão útil, pela mediana. Um nó na
+    // profundidade d com n luzes sempre tem n <= 2^(MAX_DEPTH - d): o SAOH só
+    // é tentado se até a divisão mais desigual (1 e n - 1) mantiver isso nos
+    // filhos, senão a mediana mantém. Assim nenhuma folha passa de MAX_DEPTH
+    // e o deslocamento do caminho em split() nunca chega a 64 bits.
+    int choose_split(std::vector<int>& order, int begin, int end, const LightBounds& bounds, int depth,
+                     const std::vector<LightBounds>& lights) {
+        Point3 clo(1e30f, 1e30f, 1e30f), chi(-1e30f, -1e30f, -1e30f);
+        for (int i = begin; i < end; i++) {
+            Point3 c = lights[order[i]].center();
+            clo = Point3(std::min(clo.x, c.x), std::min(clo.y, c.y), std::min(clo.z, c.z));
+            chi = Point3(std::max(chi.x, c.x), std::max(chi.y, c.y), std::max(chi.z, c.z));
+        }
+        Vec3 extent = chi - clo;
+        auto component = [](const Vec3& v, int axis) { return axis == 0 ? v.x : axis == 1 ? v.y : v.z; };
+        Vec3 box = bounds.hi - bounds.lo;
+        float max_box = std::max({box.x, box.y, box.z});
+
+        float best_cost = 1e30f;
+        int best_axis = -1, best_bucket = 0;
+        const int budget = MAX_DEPTH - depth - 1;   // Profundidade que sobra abaixo dos filhos
+        if (budget >= 63 || static_cast<uint64_t>(end - begin - 1) <= (uint64_t(1) << budget)) {
+            for (int axis = 0; axis < 3; axis++) {
+                float span = component(extent, axis);
+                if (span <= 0.0f) continue;
+                auto bucket_of = [&](int light) {
+                    float t = (component(lights[light].center() - clo, axis)) / span;
+                    return std::min(static_cast<int>(t * BUCKETS), BUCKETS - 1);
+                };
+                LightBounds buckets[BUCKETS];
+                for (int i = begin; i < end; i++) {
+                    int b = bucket_of(order[i]);
+                    buckets[b] = LightBounds::merge(buckets[b], lights[order[i]]);
+                }
+                // Caixas achatadas no eixo contam como se fossem cubos (fator Kr)
+                float kr = max_box / std::max(component(box, axis), 1e-6f);
+                LightBounds right[BUCKETS];     // right[b]: intervalos b..BUCKETS-1
+                right[BUCKETS - 1] = buckets[BUCKETS - 1];
+                for (int b = BUCKETS - 2; b >= 0; b--) right[b] = LightBounds::merge(buckets[b], right[b + 1]);
+                LightBounds left;
+                for (int b = 0; b < BUCKETS - 1; b++) {
+                    left = LightBounds::merge(left, buckets[b]);
+                    if (left.power <= 0.0f || right[b + 1].power <= 0.0f) continue;
+                    float cost = kr * (left.cost() + right[b + 1].cost());
+                    if (cost < best_cost) {
+                        best_cost = cost;
+                        best_axis = axis;
+                        best_bucket = b;
+                    }
+                }
+            }
+        }
+
+        if (best_axis >= 0) {
+            auto first_right = std::partition(order.begin() + begin, order.begin() + end, [&](int light) {
+                float t = component(lights[light].center() - clo, best_axis) / component(extent, best_axis);
+                return std::min(static_cast<int>(t * BUCKETS), BUCKETS - 1) <= best_bucket;
+            });
+            int mid = static_cast<int>(first_right - order.begin());
+            if (mid > begin && mid < end) return mid;
+        }
+
+        // Mediana no eixo mais longo dos centros
+        int axis = extent.x >= extent.y && extent.x >= extent.z ? 0 : extent.y >= extent.z ? 1 : 2;
+        int mid = (begin + end) / 2;
+        std::nth_element(order.begin() + begin, order.begin() + mid, order.begin() + end, [&](int a, int b) {
+            return component(lights[a].center(), axis) < component(lights[b].center(), axis);
+        });
+        return mid;
+    }
+};
+
+#endif
@@ -0,0 +1,218 @@
+#ifndef LIGHTS_H
+#define LIGHTS_H
+
+#include <cmath>
+#include <vector>
+#include <cstdint>
+#include <algorithm>
+#include "vec3.h"
+#include "sphere.h"
+#include "obj_loader.h"
+#include "light_bvh.h"
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+// Tabela de alias (Walker / Vose): sorteia o índice i com probabilidade
+// proporcional a weights[i] em O(1), qualquer que seja o número de pesos.
+// Cada coluna guarda o limiar do próprio índice e o índice "emprestado".
+struct AliasTable {
+    std::vector<float> threshold;
+    std::vector<uint32_t> alias;
+
+    void build(const std::vector<double>& weights) {
+        const size_t n = weights.size();
+        threshold.assign(n, 1.0f);
+        alias.resize(n);
+        for (size_t i = 0; i < n; i++) alias[i] = static_cast<uint32_t>(i);
+
+        double total = 0.0;
+        for (double w : weights) total += w;
+        if (n == 0 || total <= 0.0) return;
+
+        // Pesos escalados para média 1: as colunas abaixo de 1 pegam o resto
+        // de uma coluna acima de 1
+        std::vector<double> scaled(n);
+        std::vector<uint32_t> small, large;
+        for (size_t i = 0; i < n; i++) {
+            scaled[i] = weights[i] * n / total;
+            (scaled[i] < 1.0 ? small : large).push_back(static_cast<uint32_t>(i));
+        }
+        while (!small.empty() && !large.empty()) {
+            uint32_t s = small.back(); small.pop_back();
+            uint32_t l = large.back();
+            threshold[s] = static_cast<float>(scaled[s]);
+            alias[s] = l;
+            scaled[l] -= 1.0 - scaled[s];
+            if (scaled[l] < 1.0) {
+                large.pop_back();
+                small.push_back(l);
+            }
+        }
+        // O que sobra (erro de arredondamento) fica com limiar 1
+        for (uint32_t i : small) threshold[i] = 1.0f;
+        for (uint32_t i : large) threshold[i] = 1.0f;
+    }
+
+    // Índice sorteado por u uniforme em [0, 1)
+    uint32_t sample(float u) const {
+        const size_t n = threshold.size();
+        float x = u * n;
+        uint32_t i = std::min(static_cast<uint32_t>(x), static_cast<uint32_t>(n - 1));
+        return (x - i) < threshold[i] ? i : alias[i];
+    }
+};
+
+// Ponto sorteado numa luz
+struct LightSample {
+    Point3 p;
+    Vec3 normal;        // Lado que emite
+    Color emission;
+    float pdf_area;     // Densidade por área (já inclui a escolha da luz)
+};
+
+// Como a luz direta escolhe a luz de cada amostra
+enum LightSelection {
+    LIGHT_SELECT_POWER = 0, // Pela potência (tabela de alias), igual em todo ponto
+    LIGHT_SELECT_BVH        // Pela importância estimada no ponto (hierarquia de luzes)
+};
+
+// Luzes de área para a luz direta: todos os triângulos e esferas com emissão
+// (os planos infinitos não podem ser amostrados). O ponto é uniforme na área
+// da luz escolhida; a escolha vem da tabela de alias pela potência (a mesma
+// em todo ponto, O(1)) ou da hierarquia de luzes (light_bvh.h), que olha a
+// distância, a orientação e o lado da superfície: com milhares de luzes
+// pequenas só as próximas e voltadas para o ponto recebem amostras, em
+// O(log n).
+//
+// Os triângulos emitem só pelo lado da normal geométrica (ordem dos vértices)
+// e as esferas para fora. build() grava em cada primitiva o índice da sua luz
+// ('light'), que o HitRecord carrega até o peso MIS.
+class LightSampler {
+public:
+    void build(std::vector<Triangle>& triangles, std::vector<Sphere>& spheres) {
+        emitters_.clear();
+        std::vector<double> power;
+        std::vector<LightBounds> bounds;
+        for (auto& tri : triangles) {
+            tri.light = -1;
+            if (luminance(tri.emission) <= 0.0f) continue;
+            Emitter e;
+            e.origin = tri.v0;
+            e.e1 = tri.v1 - tri.v0;
+            e.e2 = tri.v2 - tri.v0;
+            e.normal = tri.normal;
+            e.emission = tri.emission;
+            e.radius = 0.0f;
+            double area = 0.5 * Vec3::cross(e.e1, e.e2).length();
+            if (area <= 0.0) continue;
+            e.area = static_cast<float>(area);
+            tri.light = static_cast<int>(emitters_.size());
+            emitters_.push_back(e);
+            power.push_back(M_PI * luminance(tri.emission) * area);
+
+            LightBounds b;
+            b.lo = Point3(std::min({tri.v0.x, tri.v1.x, tri.v2.x}), std::min({tri.v0.y, tri.v1.y, tri.v2.y}),
+                          std::min({tri.v0.z, tri.v1.z, tri.v2.z}));
+            b.hi = Point3(std::max({tri.v0.x, tri.v1.x, tri.v2.x}), std::max({tri.v0.y, tri.v1.y, tri.v2.y}),
+                          std::max({tri.v0.z, tri.v1.z, tri.v2.z}));
+            b.axis = tri.normal;
+            b.cos_o = 1.0f;     // Uma só normal
+            b.cos_e = 0.0f;     // Emite no hemisfério inteiro
+            b.power = static_cast<float>(power.back());
+            bounds.push_back(b);
+        }
+        for (auto& sphere : spheres) {
+            sphere.light = -1;
+            if (luminance(sphere.emission) <= 0.0f) continue;
+            Emitter e;
+            e.origin = sphere.center;
+            e.emission = sphere.emission;
+            e.radius = sphere.radius;
+            e.area = 4.0f * static_cast<float>(M_PI) * sphere.radius * sphere.radius;
+            sphere.light = static_cast<int>(emitters_.size());
+            emitters_.push_back(e);
+            power.push_back(M_PI * luminance(sphere.emission) * 4.0 * M_PI * sphere.radius * sphere.radius);
+
+            LightBounds b;
+            Vec3 r(sphere.radius, sphere.radius, sphere.radius);
+            b.lo = sphere.center - r;
+            b.hi = sphere.center + r;
+            b.cos_o = -1.0f;    // Normais em todas as direções
+            b.cos_e = 0.0f;
+            b.power = static_cast<float>(power.back());
+            bounds.push_back(b);
+        }
+
+        total_power_ = 0.0;
+        for (double p : power) total_power_ += p;
+        pdf_scale_ = total_power_ > 0.0 ? static_cast<float>(M_PI / total_power_) : 0.0f;
+        table_.build(power);
+        bvh_.build(bounds);
+    }
+
+    bool empty() const { return emitters_.empty(); }
+    size_t size() const { return emitters_.size(); }
+    double total_power() const { return total_power_; }
+    const LightBVH& hierarchy() const { return bvh_; }
+
+    // Sorteia uma luz (u_light) para o ponto 'p' de normal 'n' e um ponto
+    // nela (u1, u2). false se nenhuma luz pode iluminar o ponto.
+    bool sample(LightSelection mode, const Point3& p, const Vec3& n, float u_light, float u1, float u2,
+                LightSample& s) const {
+        int index;
+        float pmf = 0.0f;
+        if (mode == LIGHT_SELECT_BVH) {
+            index = bvh_.sample(p, n, u_light, pmf);
+            if (index < 0) return false;
+        } else {
+            index = static_cast<int>(table_.sample(u_light));
+        }
+        const Emitter& e = emitters_[index];
+        s.emission = e.emission;
+        // Pela potência a densidade por área é a mesma em toda luz: pi * L / potência total
+        s.pdf_area = mode == LIGHT_SELECT_BVH ? pmf / e.area : pdf_scale_ * luminance(e.emission);
+        if (e.radius > 0.0f) {
+            // Uniforme na superfície da esfera
+            float z = 1.0f - 2.0f * u1;
+            float r = std::sqrt(std::max(0.0f, 1.0f - z * z));
+            float phi = 2.0f * static_cast<float>(M_PI) * u2;
+            s.normal = Vec3(r * std::cos(phi), r * std::sin(phi), z);
+            s.p = e.origin + s.normal * e.radius;
+        } else {
+            // Uniforme no triângulo
+            float su = std::sqrt(u1);
+            s.p = e.origin + e.e1 * (su * (1.0f - u2)) + e.e2 * (su * u2);
+            s.normal = e.normal;
+        }
+        return s.pdf_area > 0.0f;
+    }
+
+    // Densidade por área com que sample(), no ponto 'p' de normal 'n', gera
+    // um ponto da luz 'light' (para o peso MIS dos raios que a acertam por acaso)
+    float pdf_area(LightSelection mode, int light, const Point3& p, const Vec3& n) const {
+        if (light < 0 || light >= static_cast<int>(emitters_.size())) return 0.0f;
+        const Emitter& e = emitters_[light];
+        if (mode == LIGHT_SELECT_BVH) return bvh_.pmf(light, p, n) / e.area;
+        return pdf_scale_ * luminance(e.emission);
+    }
+
+private:
+    struct Emitter {
+        Point3 origin;      // Vértice 0 ou centro da esfera
+        Vec3 e1, e2;        // Arestas do triângulo
+        Vec3 normal;
+        Color emission;
+        float radius;       // > 0 = esfera
+        float area;
+    };
+
+    std::vector<Emitter> emitters_;
+    AliasTable table_;
+    LightBVH bvh_;
+    double total_power_ = 0.0;
+    float pdf_scale_ = 0.0f;
+};
+
+#endif
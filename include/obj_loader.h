@@ -2,6 +2,7 @@
 #define OBJ_LOADER_H
 
 #include "ray.h"
+#include <map>
 #include <vector>
 #include <string>
 #include <fstream>
@@ -17,9 +18,11 @@ struct Triangle {
     Color emission;
     MaterialType mat_type; // Novo campo
     float fuzz;
+    int object_id;         // Grupo 'usemtl' de origem (-1 = avulso)
+    int light = -1;        // Índice em scene.lights (LightSampler::build)
 
-    Triangle(Point3 v0, Point3 v1, Point3 v2, Color a, MaterialType t = DIFFUSE)
-        : v0(v0), v1(v1), v2(v2), albedo(a), emission(Color(0,0,0)), mat_type(t), fuzz(0.0f) {
+    Triangle(Point3 v0, Point3 v1, Point3 v2, Color a, MaterialType t = DIFFUSE, int object_id = -1)
+        : v0(v0), v1(v1), v2(v2), albedo(a), emission(Color(0,0,0)), mat_type(t), fuzz(0.0f), object_id(object_id) {
         Vec3 e1 = v1 - v0;
         Vec3 e2 = v2 - v0;
         normal = Vec3::cross(e1, e2).normalized();
@@ -46,6 +49,13 @@ struct Triangle {
         float t = Vec3::dot(e2, qvec) * inv_det;
         if (t < t_min || t > t_max) return false;
         
+        fill_record(r, t, rec);
+        return true;
+    }
+    
+    // Preenche o HitRecord para uma interseção já validada em 't'
+    // (compartilhado com o teste SIMD de 8 triângulos)
+    void fill_record(const Ray& r, float t, HitRecord& rec) const {
         rec.t = t;
         rec.p = r.at(t);
         rec.set_face_normal(r, normal);
@@ -55,13 +65,52 @@ struct Triangle {
         rec.emission = emission;
         rec.mat_type = mat_type;
         rec.fuzz = fuzz;
-        
-        return true;
+        rec.object_id = object_id;
+        rec.light = light;
     }
 };
 
+// Emissão padrão de 'usemtl light' quando o MTL não define Ke (radiância da
+// luz da Cornell Box)
+const Color DEFAULT_LIGHT_EMISSION(17.0f, 12.0f, 4.0f);
+
+// Material lido do arquivo MTL (só o que o renderizador usa)
+struct MtlMaterial {
+    bool has_kd = false;
+    Color kd;
+    Color ke;   // Emissão (Ke); zero = não emite
+};
+
 class OBJLoader {
 public:
+    // Lê 'newmtl', 'Kd' e 'Ke' de um arquivo MTL
+    static std::map<std::string, MtlMaterial> load_mtl(const std::string& filename) {
+        std::map<std::string, MtlMaterial> materials;
+        std::ifstream file(filename);
+        if (!file.is_open()) {
+            std::cerr << "AVISO: não foi possível abrir " << filename << std::endl;
+            return materials;
+        }
+        MtlMaterial* current = nullptr;
+        std::string line;
+        while (std::getline(file, line)) {
+            std::istringstream iss(line);
+            std::string type;
+            iss >> type;
+            if (type == "newmtl") {
+                std::string name;
+                iss >> name;
+                current = &materials[name];
+            } else if (current && type == "Kd") {
+                iss >> current->kd.x >> current->kd.y >> current->kd.z;
+                current->has_kd = true;
+            } else if (current && type == "Ke") {
+                iss >> current->ke.x >> current->ke.y >> current->ke.z;
+            }
+        }
+        return materials;
+    }
+
     static std::vector<Triangle> load(const std::string& filename) {
         std::vector<Triangle> triangles;
         std::vector<Point3> vertices;
@@ -79,7 +128,10 @@ public:
         
         // Estado atual do parser
         Color current_color = white_color;
+        Color current_emission(0, 0, 0);
         MaterialType current_type = DIFFUSE; 
+        int current_object = -1; // Cada 'usemtl' inicia um novo objeto
+        std::map<std::string, MtlMaterial> materials;
 
         std::string line;
         while (std::getline(file, line)) {
@@ -92,9 +144,19 @@ public:
                 iss >> x >> y >> z;
                 vertices.push_back(Point3(x, y, z));
             }
+            else if (type == "mtllib") {
+                // Caminho relativo à pasta do OBJ
+                std::string mtl_name;
+                iss >> mtl_name;
+                size_t slash = filename.find_last_of("/\\");
+                std::string dir = slash == std::string::npos ? "" : filename.substr(0, slash + 1);
+                for (const auto& [name, mat] : load_mtl(dir + mtl_name)) materials[name] = mat;
+            }
             else if (type == "usemtl") {
                 std::string mat_name;
                 iss >> mat_name;
+                current_object++;
+                current_emission = Color(0, 0, 0);
                 
                 // Lógica simples para detectar materiais pelo nome
                 if (mat_name.find("red") != std::string::npos) {
@@ -113,11 +175,24 @@ public:
                     // Marcamos as caixas como TEXTURED
                     current_type = TEXTURED; 
                 }
+                else if (mat_name.find("light") != std::string::npos) {
+                    // Luz de área: triângulos emissivos
+                    current_color = white_color;
+                    current_type = DIFFUSE;
+                    current_emission = DEFAULT_LIGHT_EMISSION;
+                }
                 else {
                     // Paredes brancas, teto, chão
                     current_color = white_color;
                     current_type = DIFFUSE;
                 }
+                
+                // O MTL, quando define, manda na cor e na emissão
+                auto mat = materials.find(mat_name);
+                if (mat != materials.end()) {
+                    if (mat->second.has_kd) current_color = mat->second.kd;
+                    if (luminance(mat->second.ke) > 0.0f) current_emission = mat->second.ke;
+                }
             }
             else if (type == "f") {
                 std::vector<int> idx;
@@ -131,11 +206,13 @@ public:
                 
                 if (idx.size() >= 3) {
                     // Triângulo 1
-                    triangles.push_back(Triangle(vertices[idx[0]], vertices[idx[1]], vertices[idx[2]], current_color, current_type));
+                    triangles.push_back(Triangle(vertices[idx[0]], vertices[idx[1]], vertices[idx[2]], current_color, current_type, current_object));
+                    triangles.back().emission = current_emission;
                     
                     // Triângulo 2 (se for quadrado/quad)
                     if (idx.size() == 4) {
-                        triangles.push_back(Triangle(vertices[idx[0]], vertices[idx[2]], vertices[idx[3]], current_color, current_type));
+                        triangles.push_back(Triangle(vertices[idx[0]], vertices[idx[2]], vertices[idx[3]], current_color, current_type, current_object));
+                        triangles.back().emission = current_emission;
                     }
                 }
             }
@@ -2,8 +2,10 @@
 #define PERLIN_H
 
 #include "vec3.h"
+#include "simd.h"
 #include <cmath>
 #include <random>
+#include <algorithm>
 
 class PerlinNoise {
 private:
@@ -90,6 +92,170 @@ public:
         
         return total / max_value;
     }
+    
+    // Número (fracionário) de oitavas abaixo do limite de Nyquist para uma área
+    // de largura 'footprint' em coordenadas de ruído. A oitava i tem frequência
+    // 2^i e só é mantida enquanto 2^i * footprint <= 0.5. Pelo menos 1 oitava.
+    static float lod_octaves(float footprint, int octaves) {
+        if (footprint <= 0.0f) return static_cast<float>(octaves);
+        float n = std::log2(0.5f / footprint) + 1.0f;
+        return std::clamp(n, 1.0f, static_cast<float>(octaves));
+    }
+    
+    // octave_noise limitado a 'lod' oitavas (a última com peso fracionário,
+    // para não criar degraus). A normalização continua sendo a de todas as
+    // oitavas: as removidas contribuem com a média delas, que é zero.
+    float octave_noise_lod(float x, float y, float z, int octaves, float persistence, float lod) const {
+        float total = 0.0f;
+        float frequency = 1.0f;
+        float amplitude = 1.0f;
+        float max_value = 0.0f;
+        
+        for (int i = 0; i < octaves; i++) {
+            float weight = std::clamp(lod - i, 0.0f, 1.0f);
+            if (weight > 0.0f) {
+                total += noise(x * frequency, y * frequency, z * frequency) * amplitude * weight;
+            }
+            max_value += amplitude;
+            amplitude *= persistence;
+            frequency *= 2.0f;
+        }
+        
+        return total / max_value;
+    }
+    
+#ifdef PT_SIMD_AVX2
+private:
+    static __m256 fade8(__m256 t) {
+        __m256 k = _mm256_fmadd_ps(t, _mm256_set1_ps(6.0f), _mm256_set1_ps(-15.0f));
+        k = _mm256_fmadd_ps(t, k, _mm256_set1_ps(10.0f));
+        return _mm256_mul_ps(_mm256_mul_ps(_mm256_mul_ps(t, t), t), k);
+    }
+    
+    static __m256 lerp8(__m256 t, __m256 a, __m256 b) {
+        return _mm256_fmadd_ps(t, _mm256_sub_ps(b, a), a);
+    }
+    
+    // Mesma tabela de gradientes de grad(), sem desvios: as escolhas viram
+    // blends por máscara e os sinais viram XOR no bit de sinal
+    static __m256 grad8(__m256i hash, __m256 x, __m256 y, __m256 z) {
+        __m256i h = _mm256_and_si256(hash, _mm256_set1_epi32(15));
+        
+        __m256 h_lt8 = _mm256_castsi256_ps(_mm256_cmpgt_epi32(_mm256_set1_epi32(8), h));
+        __m256 h_lt4 = _mm256_castsi256_ps(_mm256_cmpgt_epi32(_mm256_set1_epi32(4), h));
+        __m256 h_12_14 = _mm256_castsi256_ps(_mm256_or_si256(
+            _mm256_cmpeq_epi32(h, _mm256_set1_epi32(12)),
+            _mm256_cmpeq_epi32(h, _mm256_set1_epi32(14))));
+        
+        __m256 u = _mm256_blendv_ps(y, x, h_lt8);
+        __m256 v = _mm256_blendv_ps(_mm256_blendv_ps(z, x, h_12_14), y, h_lt4);
+        
+        __m256 sign_u = _mm256_castsi256_ps(_mm256_slli_epi32(_mm256_and_si256(h, _mm256_set1_epi32(1)), 31));
+        __m256 sign_v = _mm256_castsi256_ps(_mm256_slli_epi32(_mm256_and_si256(h, _mm256_set1_epi32(2)), 30));
+        return _mm256_add_ps(_mm256_xor_ps(u, sign_u), _mm256_xor_ps(v, sign_v));
+    }
+    
+    __m256i perm8(__m256i idx) const {
+        return _mm256_i32gather_epi32(perm, idx, 4);
+    }
+    
+public:
+    // Avalia o ruído em 8 pontos de uma vez (mesmo resultado de noise())
+    __m256 noise8(__m256 x, __m256 y, __m256 z) const {
+        __m256 fx = _mm256_floor_ps(x);
+        __m256 fy = _mm256_floor_ps(y);
+        __m256 fz = _mm256_floor_ps(z);
+        
+        const __m256i mask = _mm256_set1_epi32(255);
+        const __m256i one = _mm256_set1_epi32(1);
+        __m256i X = _mm256_and_si256(_mm256_cvttps_epi32(fx), mask);
+        __m256i Y = _mm256_and_si256(_mm256_cvttps_epi32(fy), mask);
+        __m256i Z = _mm256_and_si256(_mm256_cvttps_epi32(fz), mask);
+        
+        x = _mm256_sub_ps(x, fx);
+        y = _mm256_sub_ps(y, fy);
+        z = _mm256_sub_ps(z, fz);
+        
+        __m256 u = fade8(x);
+        __m256 v = fade8(y);
+        __m256 w = fade8(z);
+        
+        // Gathers na tabela de permutação
+        __m256i A  = _mm256_add_epi32(perm8(X), Y);
+        __m256i AA = _mm256_add_epi32(perm8(A), Z);
+        __m256i AB = _mm256_add_epi32(perm8(_mm256_add_epi32(A, one)), Z);
+        __m256i B  = _mm256_add_epi32(perm8(_mm256_add_epi32(X, one)), Y);
+        __m256i BA = _mm256_add_epi32(perm8(B), Z);
+        __m256i BB = _mm256_add_epi32(perm8(_mm256_add_epi32(B, one)), Z);
+        
+        const __m256 f1 = _mm256_set1_ps(1.0f);
+        __m256 x1 = _mm256_sub_ps(x, f1);
+        __m256 y1 = _mm256_sub_ps(y, f1);
+        __m256 z1 = _mm256_sub_ps(z, f1);
+        
+        __m256 g000 = grad8(perm8(AA), x, y, z);
+        __m256 g100 = grad8(perm8(BA), x1, y, z);
+        __m256 g010 = grad8(perm8(AB), x, y1, z);
+        __m256 g110 = grad8(perm8(BB), x1, y1, z);
+        __m256 g001 = grad8(perm8(_mm256_add_epi32(AA, one)), x, y, z1);
+        __m256 g101 = grad8(perm8(_mm256_add_epi32(BA, one)), x1, y, z1);
+        __m256 g011 = grad8(perm8(_mm256_add_epi32(AB, one)), x, y1, z1);
+        __m256 g111 = grad8(perm8(_mm256_add_epi32(BB, one)), x1, y1, z1);
+        
+        return lerp8(w,
+            lerp8(v, lerp8(u, g000, g100), lerp8(u, g010, g110)),
+            lerp8(v, lerp8(u, g001, g101), lerp8(u, g011, g111))
+        );
+    }
+    
+    __m256 octave_noise8(__m256 x, __m256 y, __m256 z, int octaves, float persistence = 0.5f) const {
+        return octave_noise8_lod(x, y, z, octaves, persistence, _mm256_set1_ps(static_cast<float>(octaves)));
+    }
+    
+    // Versão com LOD por lane (ver octave_noise_lod). As oitavas acima do LOD
+    // de todas as 8 lanes não são avaliadas.
+    __m256 octave_noise8_lod(__m256 x, __m256 y, __m256 z, int octaves, float persistence, __m256 lod) const {
+        __m256 total = _mm256_setzero_ps();
+        float frequency = 1.0f;
+        float amplitude = 1.0f;
+        float max_value = 0.0f;
+        
+        for (int i = 0; i < octaves; i++) {
+            __m256 weight = _mm256_sub_ps(lod, _mm256_set1_ps(static_cast<float>(i)));
+            weight = _mm256_min_ps(_mm256_max_ps(weight, _mm256_setzero_ps()), _mm256_set1_ps(1.0f));
+            
+            if (_mm256_movemask_ps(_mm256_cmp_ps(weight, _mm256_setzero_ps(), _CMP_GT_OQ)) != 0) {
+                __m256 f = _mm256_set1_ps(frequency);
+                __m256 n = noise8(_mm256_mul_ps(x, f), _mm256_mul_ps(y, f), _mm256_mul_ps(z, f));
+                total = _mm256_fmadd_ps(n, _mm256_mul_ps(weight, _mm256_set1_ps(amplitude)), total);
+            }
+            max_value += amplitude;
+            amplitude *= persistence;
+            frequency *= 2.0f;
+        }
+        
+        return _mm256_mul_ps(total, _mm256_set1_ps(1.0f / max_value));
+    }
+#endif
+    
+    // API em lote: octave_noise para 'n' pontos (8 por vez com AVX2).
+    // 'lod' opcional: número de oitavas por ponto (ver lod_octaves).
+    void octave_noise_batch(const float* x, const float* y, const float* z, float* out,
+                            int n, int octaves, float persistence = 0.5f, const float* lod = nullptr) const {
+        int i = 0;
+#ifdef PT_SIMD_AVX2
+        for (; i + 8 <= n; i += 8) {
+            __m256 l = lod ? _mm256_loadu_ps(lod + i) : _mm256_set1_ps(static_cast<float>(octaves));
+            __m256 r = octave_noise8_lod(_mm256_loadu_ps(x + i), _mm256_loadu_ps(y + i), _mm256_loadu_ps(z + i),
+                                         octaves, persistence, l);
+            _mm256_storeu_ps(out + i, r);
+        }
+#endif
+        for (; i < n; i++) {
+            out[i] = lod ? octave_noise_lod(x[i], y[i], z[i], octaves, persistence, lod[i])
+                         : octave_noise(x[i], y[i], z[i], octaves, persistence);
+        }
+    }
 };
 
 #endif
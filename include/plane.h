@@ -27,6 +27,8 @@ public:
         rec.emission = emission;
         rec.mat_type = DIFFUSE;
         rec.fuzz = 0.0f;
+        rec.object_id = -1;
+        rec.light = -1;
         
         return true;
     }
@@ -7,6 +7,12 @@ struct Ray {
     Point3 origin;
     Vec3 direction;
     
+    // Diferenciais de raio: raios vizinhos deslocados em x e y na tela.
+    // Servem para estimar a área coberta pelo raio nas interseções (LOD de textura).
+    bool has_differentials = false;
+    Point3 rx_origin, ry_origin;
+    Vec3 rx_direction, ry_direction;
+    
     Ray() {}
     Ray(const Point3& origin, const Vec3& direction) 
         : origin(origin), direction(direction) {}
@@ -31,6 +37,10 @@ struct HitRecord {
     // ADICIONE ESTES DOIS CAMPOS:
     MaterialType mat_type; 
     float fuzz;
+    int object_id;      // Objeto do OBJ (grupo usemtl) ou -1 para primitivas analíticas
+    int light;          // Índice em scene.lights se a luz direta também sorteia este objeto (-1 = não)
+    Vec3 dpdx, dpdy;    // Variação do ponto entre raios vizinhos (diferenciais)
+    float footprint;    // Largura da área coberta pelo raio (0 = desconhecida)
     bool front_face;    // Se acertou face frontal
     
     void set_face_normal(const Ray& r, const Vec3& outward_normal) {
@@ -0,0 +1,272 @@
+#ifndef RENDER_CONFIG_H
+#define RENDER_CONFIG_H
+
+#include <string>
+#include <cstdlib>
+#include <vector>
+#include <fstream>
+#include <sstream>
+#include <iostream>
+#include "vec3.h"
+#include "image_io.h"
+#include "tonemap.h"
+#include "integrator.h"
+
+// Configuração da renderização em tempo de execução. Vem de um arquivo de
+// trabalho (--config) e de pares chave=valor na linha de comando, aplicados
+// na ordem em que aparecem (o último vence). Formato do arquivo: um
+// chave=valor por linha (ou vários separados por espaço); '#' começa um
+// comentário. Exemplo:
+//
+//   # Varredura de profundidade
+//   width=640 height=360 spp=256
+//   max_depth=12 rr_depth=4
+//   cam=0,1,3 target=0,1,0 fov=40
+//   env=scenes/ceu.hdr env_scale=1 env_rotation=90
+//   threads=8 tile=32 sampler=stratified
+//   pfm=1 denoise=1 out=output/teste
+//
+// As chaves estão em RenderConfig::set; os padrões são os valores que eram
+// constantes em main.cpp.
+
+enum SamplerType {
+    SAMPLER_RANDOM = 0,     // Posição no pixel uniforme e independente
+    SAMPLER_STRATIFIED      // Grade n x n no pixel (n² <= amostras da passada), com jitter
+};
+
+struct RenderConfig {
+    // Imagem e amostragem
+    int width = 512;
+    int height = 512;
+    int spp = 800;
+    uint64_t seed = 0;
+    SamplerType sampler = SAMPLER_RANDOM;
+    IntegratorSettings integrator;      // max_depth, rr_depth, rr_min, rr_max, direct_light, light_sampler
+
+    // Cena e câmera
+    std::string scene = "scenes/cornell_box.obj";
+    Point3 cam_pos = Point3(0.0f, 1.0f, 3.0f);
+    Point3 cam_target = Point3(0.0f, 1.0f, 0.0f);
+    float fov = 40.0f;
+    std::string environment;            // Mapa de ambiente .hdr/.pfm (vazio = fundo constante)
+    float env_scale = 1.0f;             // Multiplica a radiância do mapa
+    float env_rotation = 0.0f;          // Graus em torno do eixo vertical
+
+    // Execução
+    int threads = 0;                    // 0 = padrão do OpenMP
+    int tile_size = 32;                 // Blocos da fila de --cameras
+    int region_tile = 16;               // Blocos de --crop e --dirty-mask
+    int pass_spp = 16;                  // Amostras por pixel de cada passada
+    bool batched = true;                // Integrador em lote (integrator.h)
+    int batch_spp = 16;
+    bool sort_rays = false;             // Reordenação dos raios secundários
+    int texture_bake_res = 0;           // Cache 3D das texturas (0 = ao vivo)
+    bool texture_lod = true;            // LOD das texturas pelos diferenciais
+    bool checkpoint = false;            // Grava <out>.ptck (ligado por --checkpoint e --resume)
+    double checkpoint_interval = 60.0;  // Segundos entre checkpoints intermediários (0 = só o final)
+    double stale_job_sec = 120.0;       // Renderização distribuída: shard abandonado
+    float bvh_rebuild_threshold = 1.5f; // Animação: reconstrói a BVH quando o custo das caixas passa disto x o do último build
+
+    // Saída: por padrão só o PNG, como antes; os outros formatos, o denoiser e
+    // os AOVs são ligados pelas chaves pfm, hdr, exr, denoise e aovs
+    std::string output = "output/render"; // Base dos nomes (sem extensão)
+    bool write_png = true;
+    bool write_pfm = false;
+    bool write_hdr = false;
+    bool write_exr = false;
+    ExrCompression exr_compression = EXR_RLE;
+    ToneOperator tone_operator = TONE_CLAMP;
+    float exposure = 1.0f;
+    float gamma = 2.2f;
+    int png_compression = 6;
+    int output_queue = 4;               // Imagens esperando a thread de gravação
+    int output_threads = 1;             // Threads OpenMP da gravação sobreposta (animação, --cameras)
+    bool denoise = false;
+    bool write_aovs = false;
+
+    // Aplica 'chave=valor'. Em caso de erro, 'error' diz o motivo.
+    bool set(const std::string& assignment, std::string& error) {
+        size_t eq = assignment.find('=');
+        if (eq == std::string::npos || eq == 0) {
+            error = "esperado chave=valor: " + assignment;
+            return false;
+        }
+        std::string key = assignment.substr(0, eq);
+        std::string text = assignment.substr(eq + 1);
+        std::istringstream value(text);
+
+        auto read_point = [&](Point3& p) {
+            char c1 = 0, c2 = 0;
+            return static_cast<bool>(value >> p.x >> c1 >> p.y >> c2 >> p.z) && c1 == ',' && c2 == ',';
+        };
+        auto read_bool = [&](bool& b) {
+            if (text == "1" || text == "true" || text == "sim") b = true;
+            else if (text == "0" || text == "false" || text == "nao" || text == "não") b = false;
+            else return false;
+            return true;
+        };
+
+        bool ok = true;
+        if (key == "width") ok = static_cast<bool>(value >> width);
+        else if (key == "height") ok = static_cast<bool>(value >> height);
+        else if (key == "spp") ok = static_cast<bool>(value >> spp);
+        else if (key == "seed") ok = static_cast<bool>(value >> seed);
+        else if (key == "max_depth") ok = static_cast<bool>(value >> integrator.max_depth);
+        else if (key == "rr_depth") ok = static_cast<bool>(value >> integrator.rr_depth);
+        else if (key == "rr_min") ok = static_cast<bool>(value >> integrator.rr_min_survival);
+        else if (key == "rr_max") ok = static_cast<bool>(value >> integrator.rr_max_survival);
+        else if (key == "direct_light") ok = read_bool(integrator.direct_light);
+        else if (key == "light_sampler") {
+            if (text == "bvh") integrator.light_selection = LIGHT_SELECT_BVH;
+            else if (text == "power") integrator.light_selection = LIGHT_SELECT_POWER;
+            else ok = false;
+        }
+        else if (key == "sampler") {
+            if (text == "random") sampler = SAMPLER_RANDOM;
+            else if (text == "stratified") sampler = SAMPLER_STRATIFIED;
+            else ok = false;
+        }
+        else if (key == "scene") scene = text;
+        else if (key == "cam") ok = read_point(cam_pos);
+        else if (key == "target") ok = read_point(cam_target);
+        else if (key == "fov") ok = static_cast<bool>(value >> fov);
+        else if (key == "env") environment = text;
+        else if (key == "env_scale") ok = static_cast<bool>(value >> env_scale);
+        else if (key == "env_rotation") ok = static_cast<bool>(value >> env_rotation);
+        else if (key == "threads") ok = static_cast<bool>(value >> threads);
+        else if (key == "tile") ok = static_cast<bool>(value >> tile_size);
+        else if (key == "region_tile") ok = static_cast<bool>(value >> region_tile);
+        else if (key == "pass_spp") ok = static_cast<bool>(value >> pass_spp);
+        else if (key == "batched") ok = read_bool(batched);
+        else if (key == "batch_spp") ok = static_cast<bool>(value >> batch_spp);
+        else if (key == "sort_rays") ok = read_bool(sort_rays);
+        else if (key == "texture_bake") ok = static_cast<bool>(value >> texture_bake_res);
+        else if (key == "texture_lod") ok = read_bool(texture_lod);
+        else if (key == "checkpoint") ok = read_bool(checkpoint);
+        else if (key == "checkpoint_interval") ok = static_cast<bool>(value >> checkpoint_interval);
+        else if (key == "stale_job") ok = static_cast<bool>(value >> stale_job_sec);
+        else if (key == "bvh_rebuild") ok = static_cast<bool>(value >> bvh_rebuild_threshold);
+        else if (key == "out") output = text;
+        else if (key == "png") ok = read_bool(write_png);
+        else if (key == "pfm") ok = read_bool(write_pfm);
+        else if (key == "hdr") ok = read_bool(write_hdr);
+        else if (key == "exr") ok = read_bool(write_exr);
+        else if (key == "exr_compression") {
+            if (text == "none") exr_compression = EXR_NONE;
+            else if (text == "rle") exr_compression = EXR_RLE;
+            else ok = false;
+        }
+        else if (key == "tonemap") {
+            if (text == "clamp") tone_operator = TONE_CLAMP;
+            else if (text == "srgb") tone_operator = TONE_SRGB;
+            else if (text == "reinhard") tone_operator = TONE_REINHARD;
+            else if (text == "aces") tone_operator = TONE_ACES;
+            else ok = false;
+        }
+        else if (key == "exposure") ok = static_cast<bool>(value >> exposure);
+        else if (key == "gamma") ok = static_cast<bool>(value >> gamma);
+        else if (key == "png_level") ok = static_cast<bool>(value >> png_compression);
+        else if (key == "output_queue") ok = static_cast<bool>(value >> output_queue);
+        else if (key == "output_threads") ok = static_cast<bool>(value >> output_threads);
+        else if (key == "denoise") ok = read_bool(denoise);
+        else if (key == "aovs") ok = read_bool(write_aovs);
+        else {
+            error = "chave desconhecida: " + key;
+            return false;
+        }
+        if (!ok) {
+            error = "valor inválido: " + assignment;
+            return false;
+        }
+        return true;
+    }
+
+    // Lê um arquivo de trabalho (ver o formato no topo)
+    bool load(const std::string& path, std::string& error) {
+        std::ifstream in(path);
+        if (!in) {
+            error = "não foi possível ler " + path;
+            return false;
+        }
+        std::string line;
+        for (int number = 1; std::getline(in, line); number++) {
+            size_t comment = line.find('#');
+            if (comment != std::string::npos) line.erase(comment);
+            std::istringstream words(line);
+            for (std::string word; words >> word;) {
+                if (!set(word, error)) {
+                    error = path + ":" + std::to_string(number) + ": " + error;
+                    return false;
+                }
+            }
+        }
+        return true;
+    }
+
+    // Todas as chaves no formato do arquivo de trabalho; load() do texto
+    // devolve a mesma configuração
+    std::string to_string() const {
+        // Menor número de dígitos que relê o mesmo float
+        auto number = [](float v) {
+            std::ostringstream text;
+            for (int digits = 6; digits <= 9; digits++) {
+                text.str("");
+                text.precision(digits);
+                text << v;
+                if (std::strtof(text.str().c_str(), nullptr) == v) break;
+            }
+            return text.str();
+        };
+        auto point = [&](const Point3& p) { return number(p.x) + "," + number(p.y) + "," + number(p.z); };
+        std::ostringstream out;
+        out.precision(17);
+        static const char* tone_names[] = {"clamp", "srgb", "reinhard", "aces"};
+        out << "width=" << width << " height=" << height << " spp=" << spp << " seed=" << seed
+            << " sampler=" << (sampler == SAMPLER_STRATIFIED ? "stratified" : "random") << "\n";
+        out << "max_depth=" << integrator.max_depth << " rr_depth=" << integrator.rr_depth
+            << " rr_min=" << number(integrator.rr_min_survival) << " rr_max=" << number(integrator.rr_max_survival)
+            << " direct_light=" << integrator.direct_light
+            << " light_sampler=" << (integrator.light_selection == LIGHT_SELECT_BVH ? "bvh" : "power") << "\n";
+        out << "scene=" << scene << " cam=" << point(cam_pos) << " target=" << point(cam_target)
+            << " fov=" << number(fov) << "\n";
+        out << "env=" << environment << " env_scale=" << number(env_scale)
+            << " env_rotation=" << number(env_rotation) << "\n";
+        out << "threads=" << threads << " tile=" << tile_size << " region_tile=" << region_tile
+            << " pass_spp=" << pass_spp << " batched=" << batched << " batch_spp=" << batch_spp
+            << " sort_rays=" << sort_rays << "\n";
+        out << "texture_bake=" << texture_bake_res << " texture_lod=" << texture_lod
+            << " checkpoint=" << checkpoint << " checkpoint_interval=" << checkpoint_interval
+            << " stale_job=" << stale_job_sec << " bvh_rebuild=" << number(bvh_rebuild_threshold) << "\n";
+        out << "out=" << output << " png=" << write_png << " pfm=" << write_pfm << " hdr=" << write_hdr
+            << " exr=" << write_exr << " exr_compression=" << (exr_compression == EXR_NONE ? "none" : "rle") << "\n";
+        out << "tonemap=" << tone_names[tone_operator] << " exposure=" << number(exposure) << " gamma=" << number(gamma)
+            << " png_level=" << png_compression << " output_queue=" << output_queue
+            << " output_threads=" << output_threads << " denoise=" << denoise << " aovs=" << write_aovs << "\n";
+        return out.str();
+    }
+
+    // Valores fora do domínio (chamar depois de todas as chaves)
+    bool validate(std::string& error) const {
+        if (width <= 0 || height <= 0 || spp <= 0 || pass_spp <= 0 || batch_spp <= 0) {
+            error = "resolução e amostras precisam ser positivas";
+        } else if (integrator.max_depth <= 0 || integrator.rr_depth < 0) {
+            error = "max_depth precisa ser positivo e rr_depth não negativo";
+        } else if (!(integrator.rr_min_survival > 0.0f && integrator.rr_min_survival <= integrator.rr_max_survival &&
+                     integrator.rr_max_survival <= 1.0f)) {
+            error = "a roleta russa precisa de 0 < rr_min <= rr_max <= 1";
+        } else if (fov <= 0.0f || fov >= 180.0f) {
+            error = "fov precisa estar em (0, 180)";
+        } else if (!(env_scale >= 0.0f)) {
+            error = "env_scale não pode ser negativo";
+        } else if (threads < 0 || tile_size <= 0 || region_tile <= 0 || output_queue <= 0 || output_threads <= 0) {
+            error = "threads, tile, region_tile, output_queue e output_threads inválidos";
+        } else if (png_compression < 0 || png_compression > 9) {
+            error = "png_level vai de 0 a 9";
+        } else {
+            return true;
+        }
+        return false;
+    }
+};
+
+#endif
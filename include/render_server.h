@@ -0,0 +1,384 @@
+#ifndef RENDER_SERVER_H
+#define RENDER_SERVER_H
+
+#include <cstdint>
+#include <cstdlib>
+#include <string>
+#include <chrono>
+#include <vector>
+#include <map>
+#include <memory>
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <condition_variable>
+#include <functional>
+#include <algorithm>
+#include <sstream>
+#include <iostream>
+#include "vec3.h"
+
+// Modo servidor: um processo de vida longa que mantém as cenas carregadas
+// (malha + estruturas de aceleração) e o pool de threads do OpenMP, e
+// recebe trabalhos por um socket Unix. Cada trabalho custa só a renderização.
+//
+// Protocolo: uma linha de texto por conexão, resposta em texto. Cada conexão
+// é lida na sua própria thread, então um cliente parado não atrasa os outros
+// comandos; quem não mandar a linha em CLIENT_TIMEOUT_SEC segundos é desconectado.
+//   render chave=valor...   enfileira (chaves em RenderJob::parse); com
+//                           wait=1 a conexão fica aberta até o fim do trabalho
+//   cancel <id>             cancela um trabalho na fila ou em andamento
+//   status                  trabalho atual e fila
+//   shutdown                termina depois do trabalho atual
+//
+// Disponível só em sistemas POSIX (sockets Unix).
+
+struct RenderJob {
+    uint64_t id = 0;
+    int priority = 0;                 // Maior primeiro; empate = ordem de chegada
+    int width = 512, height = 512;
+    int spp = 64;
+    uint64_t seed = 0;
+    std::string scene = "scenes/cornell_box.obj";
+    std::string output = "output/render.png";
+    Point3 cam_pos = Point3(0.0f, 1.0f, 3.0f);
+    Point3 cam_target = Point3(0.0f, 1.0f, 0.0f);
+    float fov = 40.0f;
+    bool wait = false;                // Responder só quando terminar
+
+    std::shared_ptr<std::atomic<bool>> cancelled = std::make_shared<std::atomic<bool>>(false);
+    int reply_fd = -1;                // Conexão esperando o resultado (wait=1)
+
+    // Chaves: width height spp seed priority scene out cam=x,y,z target=x,y,z fov wait
+    bool parse(const std::vector<std::string>& args, std::string& error) {
+        for (const auto& arg : args) {
+            size_t eq = arg.find('=');
+            if (eq == std::string::npos) {
+                error = "argumento sem '=': " + arg;
+                return false;
+            }
+            std::string key = arg.substr(0, eq);
+            std::istringstream value(arg.substr(eq + 1));
+            char c1 = ',', c2 = ',';
+            bool ok = true;
+            if (key == "width") ok = static_cast<bool>(value >> width);
+            else if (key == "height") ok = static_cast<bool>(value >> height);
+            else if (key == "spp") ok = static_cast<bool>(value >> spp);
+            else if (key == "seed") ok = static_cast<bool>(value >> seed);
+            else if (key == "priority") ok = static_cast<bool>(value >> priority);
+            else if (key == "scene") scene = value.str();
+            else if (key == "out") output = value.str();
+            else if (key == "cam") ok = static_cast<bool>(value >> cam_pos.x >> c1 >> cam_pos.y >> c2 >> cam_pos.z);
+            else if (key == "target") ok = static_cast<bool>(value >> cam_target.x >> c1 >> cam_target.y >> c2 >> cam_target.z);
+            else if (key == "fov") ok = static_cast<bool>(value >> fov);
+            else if (key == "wait") ok = static_cast<bool>(value >> wait);
+            else {
+                error = "chave desconhecida: " + key;
+                return false;
+            }
+            if (!ok || c1 != ',' || c2 != ',') {
+                error = "valor inválido: " + arg;
+                return false;
+            }
+        }
+        if (width <= 0 || height <= 0 || spp <= 0 || fov <= 0.0f || fov >= 180.0f) {
+            error = "resolução, spp ou fov inválidos";
+            return false;
+        }
+        return true;
+    }
+
+    std::string describe() const {
+        std::ostringstream out;
+        out << "#" << id << " " << width << "x" << height << " " << spp << " spp prioridade " << priority
+            << " -> " << output;
+        return out.str();
+    }
+};
+
+#ifndef _WIN32
+
+#include <csignal>
+#include <cstring>
+#include <cerrno>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <sys/un.h>
+
+namespace server_detail {
+
+inline bool send_all(int fd, const std::string& text) {
+    size_t sent = 0;
+    while (sent < text.size()) {
+        ssize_t n = ::send(fd, text.data() + sent, text.size() - sent, 0);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return false;
+        sent += static_cast<size_t>(n);
+    }
+    return true;
+}
+
+// Lê uma linha (sem o '\n'); false se a conexão fechar antes ou o prazo
+// de leitura (SO_RCVTIMEO) acabar
+inline bool read_line(int fd, std::string& line) {
+    line.clear();
+    char c;
+    while (true) {
+        ssize_t n = ::recv(fd, &c, 1, 0);
+        if (n < 0 && errno == EINTR) continue;
+        if (n < 0) return false;
+        if (n == 0) return !line.empty();
+        if (c == '\n') return true;
+        if (c != '\r') line.push_back(c);
+        if (line.size() > 4096) return false;
+    }
+}
+
+inline bool make_address(const std::string& path, sockaddr_un& addr) {
+    std::memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    if (path.size() >= sizeof(addr.sun_path)) return false;
+    std::memcpy(addr.sun_path, path.c_str(), path.size() + 1);
+    return true;
+}
+
+inline std::vector<std::string> split(const std::string& line) {
+    std::vector<std::string> words;
+    std::istringstream in(line);
+    std::string word;
+    while (in >> word) words.push_back(word);
+    return words;
+}
+
+} // namespace server_detail
+
+class RenderServer {
+public:
+    static constexpr int CLIENT_TIMEOUT_SEC = 10;  // Prazo para ler o comando e enviar respostas
+
+    // Renderiza um trabalho; deve consultar 'cancelled' entre passadas.
+    // Retorna false em erro (com a mensagem em 'error').
+    using Renderer = std::function<bool(const RenderJob&, const std::atomic<bool>& cancelled, std::string& error)>;
+
+    ~RenderServer() { close_socket(); }
+
+    bool listen(const std::string& path) {
+        sockaddr_un addr;
+        if (!server_detail::make_address(path, addr)) return false;
+
+        listen_fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+        if (listen_fd < 0) return false;
+        ::unlink(path.c_str()); // Socket de uma execução anterior
+        if (::bind(listen_fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0 ||
+            ::listen(listen_fd, 16) != 0) {
+            close_socket();
+            return false;
+        }
+        socket_path = path;
+        return true;
+    }
+
+    // Atende conexões numa thread e renderiza na thread atual até 'shutdown'
+    void run(const Renderer& render) {
+        std::signal(SIGPIPE, SIG_IGN); // Cliente que desconectou não derruba o servidor
+        std::thread acceptor([this, fd = listen_fd] { accept_loop(fd); });
+
+        while (true) {
+            RenderJob job;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                wake.wait(lock, [this] { return stopping || !queue.empty(); });
+                if (stopping) break;
+                std::pop_heap(queue.begin(), queue.end(), Order());
+                job = queue.back();
+                queue.pop_back();
+                running = std::make_unique<RenderJob>(job);
+            }
+
+            std::cout << "Renderizando " << job.describe() << std::endl;
+            auto start = std::chrono::steady_clock::now();
+            std::string error;
+            bool ok = render(job, *job.cancelled, error);
+            double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+            std::ostringstream reply;
+            if (*job.cancelled) reply << "cancelled " << job.id << "\n";
+            else if (ok) reply << "done " << job.id << " " << seconds << "\n";
+            else reply << "error " << job.id << " " << error << "\n";
+            std::cout << reply.str() << std::flush;
+
+            if (job.reply_fd >= 0) {
+                server_detail::send_all(job.reply_fd, reply.str());
+                ::close(job.reply_fd);
+            }
+            std::lock_guard<std::mutex> lock(mutex);
+            running.reset();
+        }
+
+        // Fecha o socket para destravar o accept() e avisa quem ainda espera
+        close_socket();
+        acceptor.join();
+        for (auto& job : queue) {
+            if (job.reply_fd >= 0) {
+                server_detail::send_all(job.reply_fd, "cancelled " + std::to_string(job.id) + "\n");
+                ::close(job.reply_fd);
+            }
+        }
+        queue.clear();
+    }
+
+private:
+    int listen_fd = -1;
+    std::string socket_path;
+
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::condition_variable idle;          // Uma conexão terminou
+    int connections = 0;                   // Conexões sendo atendidas
+    std::vector<RenderJob> queue;          // Heap por prioridade
+    std::unique_ptr<RenderJob> running;
+    bool stopping = false;
+    uint64_t next_id = 1;
+
+    struct Order {
+        bool operator()(const RenderJob& a, const RenderJob& b) const {
+            if (a.priority != b.priority) return a.priority < b.priority;
+            return a.id > b.id;
+        }
+    };
+
+    void close_socket() {
+        if (listen_fd >= 0) {
+            ::shutdown(listen_fd, SHUT_RDWR);
+            ::close(listen_fd);
+            listen_fd = -1;
+            ::unlink(socket_path.c_str());
+        }
+    }
+
+    void accept_loop(int server_fd) {
+        while (true) {
+            int fd = ::accept(server_fd, nullptr, nullptr);
+            if (fd < 0) {
+                if (errno == EINTR) continue;
+                break; // Socket fechado no shutdown
+            }
+            timeval timeout{CLIENT_TIMEOUT_SEC, 0};
+            ::setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+            ::setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+
+            std::lock_guard<std::mutex> lock(mutex);
+            connections++;
+            std::thread([this, fd] {
+                if (!handle(fd)) ::close(fd);
+                std::lock_guard<std::mutex> lock(mutex);
+                connections--;
+                idle.notify_all();
+            }).detach();
+        }
+        // Espera as conexões em andamento (no máximo CLIENT_TIMEOUT_SEC)
+        std::unique_lock<std::mutex> lock(mutex);
+        idle.wait(lock, [this] { return connections == 0; });
+    }
+
+    // Atende um comando. Retorna true se a conexão ficou com um trabalho (wait=1).
+    bool handle(int fd) {
+        std::string line;
+        if (!server_detail::read_line(fd, line)) return false;
+        std::vector<std::string> words = server_detail::split(line);
+        if (words.empty()) return false;
+
+        const std::string& command = words[0];
+        if (command == "render") {
+            RenderJob job;
+            std::string error;
+            if (!job.parse(std::vector<std::string>(words.begin() + 1, words.end()), error)) {
+                server_detail::send_all(fd, "error " + error + "\n");
+                return false;
+            }
+            std::lock_guard<std::mutex> lock(mutex);
+            if (stopping) {
+                server_detail::send_all(fd, "error servidor encerrando\n");
+                return false;
+            }
+            job.id = next_id++;
+            server_detail::send_all(fd, "queued " + std::to_string(job.id) + "\n");
+            if (job.wait) job.reply_fd = fd;
+            queue.push_back(job);
+            std::push_heap(queue.begin(), queue.end(), Order());
+            wake.notify_one();
+            return job.wait;
+        }
+
+        if (command == "cancel" && words.size() == 2) {
+            uint64_t id = std::strtoull(words[1].c_str(), nullptr, 10);
+            std::lock_guard<std::mutex> lock(mutex);
+            if (running && running->id == id) {
+                *running->cancelled = true;
+                server_detail::send_all(fd, "ok\n");
+                return false;
+            }
+            auto it = std::find_if(queue.begin(), queue.end(), [id](const RenderJob& j) { return j.id == id; });
+            if (it == queue.end()) {
+                server_detail::send_all(fd, "error trabalho desconhecido\n");
+                return false;
+            }
+            if (it->reply_fd >= 0) {
+                server_detail::send_all(it->reply_fd, "cancelled " + std::to_string(id) + "\n");
+                ::close(it->reply_fd);
+            }
+            queue.erase(it);
+            std::make_heap(queue.begin(), queue.end(), Order());
+            server_detail::send_all(fd, "ok\n");
+            return false;
+        }
+
+        if (command == "status") {
+            std::ostringstream out;
+            std::lock_guard<std::mutex> lock(mutex);
+            out << "running " << (running ? running->describe() : "-") << "\n";
+            std::vector<RenderJob> pending = queue;
+            std::sort(pending.begin(), pending.end(), [](const RenderJob& a, const RenderJob& b) { return Order()(b, a); });
+            for (const auto& job : pending) out << "queued " << job.describe() << "\n";
+            server_detail::send_all(fd, out.str());
+            return false;
+        }
+
+        if (command == "shutdown") {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+            wake.notify_one();
+            server_detail::send_all(fd, "ok\n");
+            return false;
+        }
+
+        server_detail::send_all(fd, "error comando desconhecido: " + command + "\n");
+        return false;
+    }
+};
+
+// Cliente: envia uma linha e imprime a resposta até o servidor fechar a conexão
+inline int submit_command(const std::string& path, const std::string& line) {
+    sockaddr_un addr;
+    if (!server_detail::make_address(path, addr)) return 1;
+    int fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0 || ::connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0) {
+        std::cerr << "ERRO: servidor não encontrado em " << path << std::endl;
+        if (fd >= 0) ::close(fd);
+        return 1;
+    }
+    server_detail::send_all(fd, line + "\n");
+
+    std::string reply;
+    char buffer[1024];
+    ssize_t n;
+    while ((n = ::recv(fd, buffer, sizeof(buffer), 0)) > 0) reply.append(buffer, static_cast<size_t>(n));
+    ::close(fd);
+    std::cout << reply << std::flush;
+    return reply.compare(0, 5, "error") == 0 || reply.find("\nerror") != std::string::npos ? 1 : 0;
+}
+
+#endif // _WIN32
+
+#endif
@@ -0,0 +1,88 @@
+#ifndef SAMPLING_H
+#define SAMPLING_H
+
+#include "vec3.h"
+#include "simd.h"
+#include <cstdint>
+#include <cmath>
+#include <algorithm>
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+// PCG32 (O'Neill): estado de 64 bits, barato de semear. Cada linha de cada
+// passada é semeada de forma determinística (seed_rng), então a renderização
+// pode ser interrompida e retomada em qualquer passada com as mesmas amostras.
+struct Pcg32 {
+    uint64_t state = 0x853c49e6748fea9bULL;
+    uint64_t inc = 0xda3e39cb94b95bdbULL;
+
+    void seed(uint64_t init_state, uint64_t sequence) {
+        state = 0;
+        inc = (sequence << 1) | 1u;
+        next();
+        state += init_state;
+        next();
+    }
+
+    uint32_t next() {
+        uint64_t old = state;
+        state = old * 6364136223846793005ULL + inc;
+        uint32_t xorshifted = static_cast<uint32_t>(((old >> 18) ^ old) >> 27);
+        uint32_t rot = static_cast<uint32_t>(old >> 59);
+        return (xorshifted >> rot) | (xorshifted << ((32 - rot) & 31));
+    }
+};
+
+// Gerador de números aleatórios thread-safe
+inline thread_local Pcg32 rng;
+
+// Mistura de 64 bits (splitmix64) para derivar sementes independentes
+inline uint64_t mix64(uint64_t x) {
+    x += 0x9e3779b97f4a7c15ULL;
+    x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+    return x ^ (x >> 31);
+}
+
+// Reinicia o gerador da thread para o fluxo 'stream' da semente 'seed'
+inline void seed_rng(uint64_t seed, uint64_t stream) {
+    rng.seed(mix64(seed ^ mix64(stream)), stream);
+}
+
+// Uniforme em [0, 1): 24 bits de mantissa
+inline float random_float() {
+    return (rng.next() >> 8) * (1.0f / 16777216.0f);
+}
+
+// Amostragem cosine-weighted hemisphere
+inline Vec3 cosine_sample_hemisphere(const Vec3& normal) {
+    float u1 = random_float();
+    float u2 = random_float();
+
+    float r = std::sqrt(u1);
+    float theta = 2.0f * M_PI * u2;
+
+    float x = r * std::cos(theta);
+    float z = r * std::sin(theta);
+    float y = std::sqrt(std::max(0.0f, 1.0f - u1));
+
+    // Criar base ortonormal ao redor da normal
+#ifdef PT_SIMD_SSE
+    Vec3A n(normal);
+    Vec3A tangent = std::abs(normal.x) > 0.1f ? Vec3A(0, 1, 0) : Vec3A(1, 0, 0);
+    tangent = Vec3A::cross(n, tangent).normalized_fast();
+    Vec3A bitangent = Vec3A::cross(n, tangent);
+
+    return Vec3A::madd(tangent, x, Vec3A::madd(n, y, bitangent * z)).normalized_fast().to_vec3();
+#else
+    Vec3 tangent = std::abs(normal.x) > 0.1f ? Vec3(0, 1, 0) : Vec3(1, 0, 0);
+    tangent = Vec3::cross(normal, tangent).normalized();
+    Vec3 bitangent = Vec3::cross(normal, tangent);
+
+    return (tangent * x + normal * y + bitangent * z).normalized();
+#endif
+}
+
+#endif
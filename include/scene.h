@@ -0,0 +1,263 @@
+#ifndef SCENE_H
+#define SCENE_H
+
+#include <vector>
+#include <algorithm>
+#include <iostream>
+#include "vec3.h"
+#include "ray.h"
+#include "sphere.h"
+#include "plane.h"
+#include "obj_loader.h"
+#include "solid_texture.h"
+#include "triangle_block.h"
+#include "bvh.h"
+#include "lights.h"
+#include "environment.h"
+#include "texture_bake.h"
+#include "stats.h"
+#include "timeline.h"
+
+// Classe de cena
+class Scene {
+public:
+    std::vector<Sphere> spheres;
+    std::vector<Plane> planes;
+    std::vector<Triangle> triangles;
+    SolidTexture solid_tex;
+    SolidTextureType texture_type = TEX_WOOD; // Textura dos objetos TEXTURED
+    
+    // Texturas pré-amostradas por objeto (opcional, ver bake_textures)
+    std::vector<BakedTexture3D> baked_textures;
+    std::vector<int> baked_index;  // object_id -> índice em baked_textures (-1 = ao vivo)
+    
+    // BVH dos triângulos; cada folha é um bloco de 8 em triangle_blocks
+    // (gerados por build(), atualizados por update())
+    TriangleBVH bvh;
+    std::vector<TriangleBlock8> triangle_blocks;
+    
+    // Caixa envolvente dos objetos finitos (planos são ignorados).
+    // Usada para quantizar origens de raios na ordenação por coerência.
+    Point3 bounds_min;
+    Point3 bounds_max;
+    
+    // Luzes de área amostradas pela luz direta (triângulos e esferas emissivos)
+    LightSampler lights;
+    
+    // Mapa de ambiente dos raios que saem da cena (vazio = fundo constante)
+    EnvironmentMap environment;
+    
+    void compute_bounds() {
+        bounds_min = Point3(1e30f, 1e30f, 1e30f);
+        bounds_max = Point3(-1e30f, -1e30f, -1e30f);
+        
+        auto expand = [&](const Point3& p) {
+            bounds_min = Point3(std::min(bounds_min.x, p.x), std::min(bounds_min.y, p.y), std::min(bounds_min.z, p.z));
+            bounds_max = Point3(std::max(bounds_max.x, p.x), std::max(bounds_max.y, p.y), std::max(bounds_max.z, p.z));
+        };
+        
+        for (const auto& tri : triangles) {
+            expand(tri.v0);
+            expand(tri.v1);
+            expand(tri.v2);
+        }
+        for (const auto& sphere : spheres) {
+            Vec3 r(sphere.radius, sphere.radius, sphere.radius);
+            expand(sphere.center - r);
+            expand(sphere.center + r);
+        }
+        
+        // Cena vazia: evita caixa invertida
+        if (bounds_min.x > bounds_max.x) {
+            bounds_min = Point3(-1, -1, -1);
+            bounds_max = Point3(1, 1, 1);
+        }
+    }
+    
+    // Prepara as estruturas derivadas. Chamar sempre que os triângulos mudarem.
+    void build() {
+        PT_TIMELINE_SCOPE("Scene::build", "cena");
+        compute_bounds();
+        lights.build(triangles, spheres);
+        bvh.build(triangles, triangle_blocks);
+    }
+    
+    // Atualiza as estruturas depois que os vértices mudaram (quadro de uma
+    // animação). Com o mesmo número de triângulos a BVH só é reajustada
+    // (refit); se o custo SAH passar de 'rebuild_threshold' vezes o do último
+    // build, ou o número de triângulos mudar, ela é reconstruída.
+    // Retorna true se reconstruiu. 'quality' recebe o custo relativo depois
+    // do refit (o que decidiu a reconstrução; 1 se a topologia mudou).
+    bool update(float rebuild_threshold, float* quality = nullptr) {
+        PT_TIMELINE_SCOPE("Scene::update", "cena");
+        float refit_quality = 1.0f;
+        bool rebuilt = bvh.primitive_count() != triangles.size();
+        if (!rebuilt) {
+            compute_bounds();
+                lights.build(triangles, spheres);
+            refit_quality = bvh.refit(triangles, triangle_blocks);
+            rebuilt = refit_quality > rebuild_threshold;
+        }
+        if (rebuilt) build();
+        if (quality) *quality = refit_quality;
+        return rebuilt;
+    }
+    
+    // Pré-amostra a textura de cada objeto TEXTURED numa grade 3D sobre a sua
+    // caixa envolvente ('resolution' amostras no eixo mais longo).
+    void bake_textures(int resolution) {
+        PT_TIMELINE_SCOPE("Scene::bake_textures", "cena");
+        baked_textures.clear();
+        baked_index.clear();
+        
+        // Caixa envolvente de cada objeto texturizado
+        std::vector<Point3> lo, hi;
+        for (const auto& tri : triangles) {
+            if (tri.mat_type != TEXTURED || tri.object_id < 0) continue;
+            if (tri.object_id >= static_cast<int>(baked_index.size())) {
+                baked_index.resize(tri.object_id + 1, -1);
+            }
+            int& slot = baked_index[tri.object_id];
+            if (slot < 0) {
+                slot = static_cast<int>(lo.size());
+                lo.push_back(Point3(1e30f, 1e30f, 1e30f));
+                hi.push_back(Point3(-1e30f, -1e30f, -1e30f));
+            }
+            for (const auto& v : {tri.v0, tri.v1, tri.v2}) {
+                lo[slot] = Point3(std::min(lo[slot].x, v.x), std::min(lo[slot].y, v.y), std::min(lo[slot].z, v.z));
+                hi[slot] = Point3(std::max(hi[slot].x, v.x), std::max(hi[slot].y, v.y), std::max(hi[slot].z, v.z));
+            }
+        }
+        
+        baked_textures.resize(lo.size());
+        size_t total_bytes = 0;
+        for (size_t i = 0; i < lo.size(); i++) {
+            BakedTexture3D& bake = baked_textures[i];
+            bake.bake(solid_tex, texture_type, lo[i], hi[i], resolution);
+            total_bytes += bake.memory_bytes();
+            
+            float rmse, max_error;
+            bake.measure_error(solid_tex, texture_type, 4096, rmse, max_error);
+            std::cout << "Textura pré-amostrada " << i << ": " << bake.nx << "x" << bake.ny << "x" << bake.nz
+                      << " | " << (bake.memory_bytes() / 1024.0) << " KB"
+                      << " | RMSE " << rmse << " | erro máx " << max_error << std::endl;
+        }
+        std::cout << "Cache de texturas: " << baked_textures.size() << " objetos, "
+                  << (total_bytes / (1024.0 * 1024.0)) << " MB" << std::endl;
+    }
+    
+    const BakedTexture3D* baked_texture(int object_id) const {
+        if (object_id < 0 || object_id >= static_cast<int>(baked_index.size())) return nullptr;
+        int slot = baked_index[object_id];
+        return slot >= 0 ? &baked_textures[slot] : nullptr;
+    }
+    
+    bool hit(const Ray& r, float t_min, float t_max, HitRecord& rec) const {
+        HitRecord temp_rec;
+        bool hit_anything = false;
+        float closest_so_far = t_max;
+        PT_STATS_ONLY(StatHitKind kind = STAT_MISS;)
+        
+        for (const auto& sphere : spheres) {
+            if (sphere.hit(r, t_min, closest_so_far, temp_rec)) {
+                hit_anything = true;
+                PT_STATS_ONLY(kind = STAT_SPHERE;)
+                closest_so_far = temp_rec.t;
+                rec = temp_rec;
+            }
+        }
+        
+        for (const auto& plane : planes) {
+            if (plane.hit(r, t_min, closest_so_far, temp_rec)) {
+                hit_anything = true;
+                PT_STATS_ONLY(kind = STAT_PLANE;)
+                closest_so_far = temp_rec.t;
+                rec = temp_rec;
+            }
+        }
+        
+#ifdef PT_SIMD_AVX2
+        Vec3x8 orig(r.origin);
+        Vec3x8 dir(r.direction);
+        const Triangle* hit_tri = nullptr;
+        
+        auto hit_block = [&](const TriangleBlock8& block) {
+            float t;
+            int lane = block.hit(orig, dir, t_min, closest_so_far, t);
+            if (lane >= 0) {
+                closest_so_far = t;
+                hit_tri = &triangles[block.index[lane]];
+            }
+        };
+        if (bvh.linear()) {
+            for (const auto& block : triangle_blocks) hit_block(block);
+        } else {
+            bvh.traverse(r, t_min, closest_so_far, [&](const BVHNode& leaf) {
+                hit_block(triangle_blocks[leaf.block]);
+                return closest_so_far;
+            });
+        }
+        
+        // O registro só é preenchido para o triângulo mais próximo
+        if (hit_tri) {
+            hit_tri->fill_record(r, closest_so_far, rec);
+            hit_anything = true;
+            PT_STATS_ONLY(kind = STAT_TRIANGLE;)
+        }
+#else
+        bvh.traverse(r, t_min, closest_so_far, [&](const BVHNode& leaf) {
+            for (int i = leaf.first; i < leaf.first + leaf.count; i++) {
+                if (triangles[bvh.order[i]].hit(r, t_min, closest_so_far, temp_rec)) {
+                    hit_anything = true;
+                    PT_STATS_ONLY(kind = STAT_TRIANGLE;)
+                    closest_so_far = temp_rec.t;
+                    rec = temp_rec;
+                }
+            }
+            return closest_so_far;
+        });
+#endif
+        
+        PT_STAT_HIT(kind);
+        return hit_anything;
+    }
+    
+    // Raio de sombra: existe algo em (t_min, t_max)? Para no primeiro acerto.
+    bool occluded(const Ray& r, float t_min, float t_max) const {
+        HitRecord temp_rec;
+        for (const auto& sphere : spheres) {
+            if (sphere.hit(r, t_min, t_max, temp_rec)) return true;
+        }
+        for (const auto& plane : planes) {
+            if (plane.hit(r, t_min, t_max, temp_rec)) return true;
+        }
+        
+        bool blocked = false;
+#ifdef PT_SIMD_AVX2
+        Vec3x8 orig(r.origin);
+        Vec3x8 dir(r.direction);
+        if (bvh.linear()) {
+            float t;
+            for (const auto& block : triangle_blocks) {
+                if (block.hit(orig, dir, t_min, t_max, t) >= 0) return true;
+            }
+            return false;
+        }
+        bvh.traverse(r, t_min, t_max, [&](const BVHNode& leaf) {
+            float t;
+            blocked = blocked || triangle_blocks[leaf.block].hit(orig, dir, t_min, t_max, t) >= 0;
+            return blocked ? -1.0f : t_max; // t_max negativo encerra a travessia
+        });
+#else
+        bvh.traverse(r, t_min, t_max, [&](const BVHNode& leaf) {
+            for (int i = leaf.first; i < leaf.first + leaf.count && !blocked; i++) {
+                blocked = triangles[bvh.order[i]].hit(r, t_min, t_max, temp_rec);
+            }
+            return blocked ? -1.0f : t_max;
+        });
+#endif
+        return blocked;
+    }
+};
+
+#endif
@@ -0,0 +1,155 @@
+#ifndef SIMD_H
+#define SIMD_H
+
+#include "vec3.h"
+#include <cmath>
+
+// Camada de matemática SIMD.
+// Vec3A: vetor 4-wide (x, y, z, 0) em um registrador SSE, para cálculos de um raio.
+// Vec3x8: 8 vetores em SoA (AVX), para kernels em lote (ex: 8 triângulos por teste).
+// Compilado com -march=native; sem AVX2+FMA o código cai nos caminhos escalares.
+
+#if defined(__AVX2__) && defined(__FMA__)
+#define PT_SIMD_AVX2 1
+#endif
+
+#if defined(__SSE4_1__)
+#define PT_SIMD_SSE 1
+#endif
+
+#if defined(PT_SIMD_SSE) || defined(PT_SIMD_AVX2)
+#include <immintrin.h>
+#endif
+
+#ifdef PT_SIMD_SSE
+
+struct alignas(16) Vec3A {
+    __m128 v;
+
+    Vec3A() : v(_mm_setzero_ps()) {}
+    explicit Vec3A(__m128 m) : v(m) {}
+    Vec3A(float x, float y, float z) : v(_mm_set_ps(0.0f, z, y, x)) {}
+    explicit Vec3A(const Vec3& a) : v(_mm_set_ps(0.0f, a.z, a.y, a.x)) {}
+
+    Vec3 to_vec3() const {
+        alignas(16) float f[4];
+        _mm_store_ps(f, v);
+        return Vec3(f[0], f[1], f[2]);
+    }
+
+    Vec3A operator+(const Vec3A& o) const { return Vec3A(_mm_add_ps(v, o.v)); }
+    Vec3A operator-(const Vec3A& o) const { return Vec3A(_mm_sub_ps(v, o.v)); }
+    Vec3A operator*(const Vec3A& o) const { return Vec3A(_mm_mul_ps(v, o.v)); }
+    Vec3A operator*(float t) const { return Vec3A(_mm_mul_ps(v, _mm_set1_ps(t))); }
+
+    // a * t + b em uma instrução FMA
+    static Vec3A madd(const Vec3A& a, float t, const Vec3A& b) {
+#ifdef __FMA__
+        return Vec3A(_mm_fmadd_ps(a.v, _mm_set1_ps(t), b.v));
+#else
+        return a * t + b;
+#endif
+    }
+
+    // Produto escalar com o resultado replicado nas lanes x, y, z (w = 0)
+    // (dpps tem latência alta; duas rotações + somas são mais rápidas)
+    static __m128 dot4(const Vec3A& a, const Vec3A& b) {
+        __m128 m = _mm_mul_ps(a.v, b.v);
+        __m128 m_yzx = _mm_shuffle_ps(m, m, _MM_SHUFFLE(3, 0, 2, 1));
+        __m128 m_zxy = _mm_shuffle_ps(m, m, _MM_SHUFFLE(3, 1, 0, 2));
+        return _mm_add_ps(_mm_add_ps(m, m_yzx), m_zxy);
+    }
+
+    static float dot(const Vec3A& a, const Vec3A& b) {
+        return _mm_cvtss_f32(dot4(a, b));
+    }
+
+    static Vec3A cross(const Vec3A& a, const Vec3A& b) {
+        // (a * b.yzx - a.yzx * b).yzx, com o primeiro produto fundido
+        __m128 a_yzx = _mm_shuffle_ps(a.v, a.v, _MM_SHUFFLE(3, 0, 2, 1));
+        __m128 b_yzx = _mm_shuffle_ps(b.v, b.v, _MM_SHUFFLE(3, 0, 2, 1));
+        __m128 c = _mm_mul_ps(a_yzx, b.v);
+#ifdef __FMA__
+        c = _mm_fmsub_ps(a.v, b_yzx, c);
+#else
+        c = _mm_sub_ps(_mm_mul_ps(a.v, b_yzx), c);
+#endif
+        return Vec3A(_mm_shuffle_ps(c, c, _MM_SHUFFLE(3, 0, 2, 1)));
+    }
+
+    // Normalização com rsqrt aproximado + um passo de Newton-Raphson
+    // (erro relativo ~1e-7, sem sqrt nem divisão)
+    Vec3A normalized_fast() const {
+        __m128 len2 = dot4(*this, *this);
+        __m128 r = _mm_rsqrt_ps(len2);
+        __m128 half_len2_r2 = _mm_mul_ps(_mm_mul_ps(_mm_set1_ps(0.5f), len2), _mm_mul_ps(r, r));
+        r = _mm_mul_ps(r, _mm_sub_ps(_mm_set1_ps(1.5f), half_len2_r2));
+        // Vetores nulos continuam nulos (mesmo contrato de Vec3::normalized)
+        __m128 valid = _mm_cmpgt_ps(len2, _mm_set1_ps(1e-16f));
+        return Vec3A(_mm_and_ps(_mm_mul_ps(v, r), valid));
+    }
+};
+
+#endif // PT_SIMD_SSE
+
+// Normalização rápida para os caminhos quentes escalares
+inline Vec3 normalize_fast(const Vec3& a) {
+#ifdef PT_SIMD_SSE
+    return Vec3A(a).normalized_fast().to_vec3();
+#else
+    return a.normalized();
+#endif
+}
+
+#ifdef PT_SIMD_AVX2
+
+struct Vec3x8 {
+    __m256 x, y, z;
+
+    Vec3x8() : x(_mm256_setzero_ps()), y(_mm256_setzero_ps()), z(_mm256_setzero_ps()) {}
+    Vec3x8(__m256 x, __m256 y, __m256 z) : x(x), y(y), z(z) {}
+
+    // Replica o mesmo vetor nas 8 lanes
+    explicit Vec3x8(const Vec3& a)
+        : x(_mm256_set1_ps(a.x)), y(_mm256_set1_ps(a.y)), z(_mm256_set1_ps(a.z)) {}
+
+    // Carrega 8 vetores de arrays SoA alinhados em 32 bytes
+    static Vec3x8 load(const float* px, const float* py, const float* pz) {
+        return Vec3x8(_mm256_load_ps(px), _mm256_load_ps(py), _mm256_load_ps(pz));
+    }
+
+    Vec3x8 operator+(const Vec3x8& o) const {
+        return Vec3x8(_mm256_add_ps(x, o.x), _mm256_add_ps(y, o.y), _mm256_add_ps(z, o.z));
+    }
+    Vec3x8 operator-(const Vec3x8& o) const {
+        return Vec3x8(_mm256_sub_ps(x, o.x), _mm256_sub_ps(y, o.y), _mm256_sub_ps(z, o.z));
+    }
+    Vec3x8 operator*(__m256 t) const {
+        return Vec3x8(_mm256_mul_ps(x, t), _mm256_mul_ps(y, t), _mm256_mul_ps(z, t));
+    }
+
+    static __m256 dot(const Vec3x8& a, const Vec3x8& b) {
+        return _mm256_fmadd_ps(a.x, b.x, _mm256_fmadd_ps(a.y, b.y, _mm256_mul_ps(a.z, b.z)));
+    }
+
+    static Vec3x8 cross(const Vec3x8& a, const Vec3x8& b) {
+        return Vec3x8(
+            _mm256_fmsub_ps(a.y, b.z, _mm256_mul_ps(a.z, b.y)),
+            _mm256_fmsub_ps(a.z, b.x, _mm256_mul_ps(a.x, b.z)),
+            _mm256_fmsub_ps(a.x, b.y, _mm256_mul_ps(a.y, b.x))
+        );
+    }
+
+    Vec3x8 normalized_fast() const {
+        __m256 len2 = dot(*this, *this);
+        __m256 r = _mm256_rsqrt_ps(len2);
+        __m256 half_len2_r2 = _mm256_mul_ps(_mm256_mul_ps(_mm256_set1_ps(0.5f), len2), _mm256_mul_ps(r, r));
+        r = _mm256_mul_ps(r, _mm256_sub_ps(_mm256_set1_ps(1.5f), half_len2_r2));
+        r = _mm256_and_ps(r, _mm256_cmp_ps(len2, _mm256_set1_ps(1e-16f), _CMP_GT_OQ));
+        return *this * r;
+    }
+};
+
+#endif // PT_SIMD_AVX2
+
+#endif
@@ -4,6 +4,15 @@
 #include "vec3.h"
 #include "perlin.h"
 #include <cmath>
+#include <algorithm>
+
+// Texturas procedurais disponíveis
+enum SolidTextureType {
+    TEX_WOOD,
+    TEX_MARBLE,
+    TEX_CLOUDS,
+    TEX_CHECKER
+};
 
 class SolidTexture {
 private:
@@ -12,9 +21,107 @@ private:
 public:
     SolidTexture(unsigned int seed = 42) : perlin(seed) {}
     
+    // As texturas com ruído aceitam a largura 'footprint' da área coberta pelo
+    // raio (em unidades de mundo). As oitavas acima do limite de Nyquist são
+    // descartadas; footprint = 0 avalia todas.
+    
     // Textura de mármore (marble)
-    Color marble(const Point3& p, float scale = 5.0f) const {
-        float noise_val = perlin.octave_noise(p.x * scale, p.y * scale, p.z * scale, 6, 0.5f);
+    Color marble(const Point3& p, float scale = 5.0f, float footprint = 0.0f) const {
+        float lod = PerlinNoise::lod_octaves(footprint * scale, 6);
+        float noise_val = perlin.octave_noise_lod(p.x * scale, p.y * scale, p.z * scale, 6, 0.5f, lod);
+        return marble_color(p, noise_val, scale);
+    }
+    
+    // Textura de madeira (wood)
+    Color wood(const Point3& p, float scale = 10.0f, float footprint = 0.0f) const {
+        float lod = PerlinNoise::lod_octaves(footprint * 2.0f, 4);
+        float noise_val = perlin.octave_noise_lod(p.x * 2.0f, p.y * 2.0f, p.z * 2.0f, 4, 0.5f, lod);
+        return wood_color(p, noise_val, scale);
+    }
+    
+    // Textura xadrez 3D
+    Color checkerboard(const Point3& p, float scale = 2.0f) const {
+        int xi = static_cast<int>(std::floor(p.x * scale));
+        int yi = static_cast<int>(std::floor(p.y * scale));
+        int zi = static_cast<int>(std::floor(p.z * scale));
+        
+        bool is_even = ((xi + yi + zi) % 2) == 0;
+        return is_even ? Color(0.9f, 0.9f, 0.9f) : Color(0.2f, 0.2f, 0.2f);
+    }
+    
+    // Textura de nuvens/fumaça
+    Color clouds(const Point3& p, float scale = 3.0f, float footprint = 0.0f) const {
+        float lod = PerlinNoise::lod_octaves(footprint * scale, 6);
+        float noise_val = perlin.octave_noise_lod(p.x * scale, p.y * scale, p.z * scale, 6, 0.5f, lod);
+        return clouds_color(noise_val);
+    }
+    
+    // Avalia a textura escolhida com os parâmetros padrão
+    Color eval(SolidTextureType type, const Point3& p, float footprint = 0.0f) const {
+        switch (type) {
+            case TEX_MARBLE:  return marble(p, 5.0f, footprint);
+            case TEX_CLOUDS:  return clouds(p, 3.0f, footprint);
+            case TEX_CHECKER: return checkerboard(p);
+            case TEX_WOOD:
+            default:          return wood(p, 10.0f, footprint);
+        }
+    }
+    
+    // 'footprints' opcional: uma largura por ponto
+    void eval_batch(SolidTextureType type, const Point3* p, Color* out, int n,
+                    const float* footprints = nullptr) const {
+        switch (type) {
+            case TEX_MARBLE: marble_batch(p, out, n, 5.0f, footprints); break;
+            case TEX_CLOUDS: clouds_batch(p, out, n, 3.0f, footprints); break;
+            case TEX_CHECKER:
+                for (int i = 0; i < n; i++) out[i] = checkerboard(p[i]);
+                break;
+            case TEX_WOOD:
+            default:         wood_batch(p, out, n, 10.0f, footprints); break;
+        }
+    }
+    
+    // Versões em lote: avaliam 'n' pontos de uma vez, com o ruído calculado
+    // 8 pontos por chamada (AVX2). Usadas pelo estágio de shading em lote.
+    void marble_batch(const Point3* p, Color* out, int n, float scale = 5.0f,
+                      const float* footprints = nullptr) const {
+        noise_batch(p, footprints, out, n, scale, 6, [&](const Point3& q, float nv) { return marble_color(q, nv, scale); });
+    }
+    
+    void wood_batch(const Point3* p, Color* out, int n, float scale = 10.0f,
+                    const float* footprints = nullptr) const {
+        noise_batch(p, footprints, out, n, 2.0f, 4, [&](const Point3& q, float nv) { return wood_color(q, nv, scale); });
+    }
+    
+    void clouds_batch(const Point3* p, Color* out, int n, float scale = 3.0f,
+                      const float* footprints = nullptr) const {
+        noise_batch(p, footprints, out, n, scale, 6, [&](const Point3&, float nv) { return clouds_color(nv); });
+    }
+    
+private:
+    // Converte blocos de pontos para SoA, avalia o ruído em lote e aplica o mapeamento de cor
+    template <typename ColorFn>
+    void noise_batch(const Point3* p, const float* footprints, Color* out, int n, float freq, int octaves,
+                     ColorFn color_fn) const {
+        const int CHUNK = 64;
+        float xs[CHUNK], ys[CHUNK], zs[CHUNK], lods[CHUNK], noise_vals[CHUNK];
+        
+        for (int base = 0; base < n; base += CHUNK) {
+            int count = std::min(CHUNK, n - base);
+            for (int i = 0; i < count; i++) {
+                xs[i] = p[base + i].x * freq;
+                ys[i] = p[base + i].y * freq;
+                zs[i] = p[base + i].z * freq;
+                if (footprints) lods[i] = PerlinNoise::lod_octaves(footprints[base + i] * freq, octaves);
+            }
+            perlin.octave_noise_batch(xs, ys, zs, noise_vals, count, octaves, 0.5f, footprints ? lods : nullptr);
+            for (int i = 0; i < count; i++) {
+                out[base + i] = color_fn(p[base + i], noise_vals[i]);
+            }
+        }
+    }
+    
+    Color marble_color(const Point3& p, float noise_val, float scale) const {
         float pattern = std::sin(p.x * scale + 3.0f * noise_val);
         float t = (pattern + 1.0f) * 0.5f; // Normaliza [0,1]
         
@@ -24,10 +131,8 @@ public:
         return white * (1.0f - t) + gray * t;
     }
     
-    // Textura de madeira (wood)
-    Color wood(const Point3& p, float scale = 10.0f) const {
+    Color wood_color(const Point3& p, float noise_val, float scale) const {
         float r = std::sqrt(p.x*p.x + p.z*p.z);
-        float noise_val = perlin.octave_noise(p.x * 2.0f, p.y * 2.0f, p.z * 2.0f, 4, 0.5f);
         float rings = std::sin(r * scale + noise_val * 3.0f);
         float t = (rings + 1.0f) * 0.5f;
         
@@ -37,19 +142,7 @@ public:
         return dark * (1.0f - t) + light * t;
     }
     
-    // Textura xadrez 3D
-    Color checkerboard(const Point3& p, float scale = 2.0f) const {
-        int xi = static_cast<int>(std::floor(p.x * scale));
-        int yi = static_cast<int>(std::floor(p.y * scale));
-        int zi = static_cast<int>(std::floor(p.z * scale));
-        
-        bool is_even = ((xi + yi + zi) % 2) == 0;
-        return is_even ? Color(0.9f, 0.9f, 0.9f) : Color(0.2f, 0.2f, 0.2f);
-    }
-    
-    // Textura de nuvens/fumaça
-    Color clouds(const Point3& p, float scale = 3.0f) const {
-        float noise_val = perlin.octave_noise(p.x * scale, p.y * scale, p.z * scale, 6, 0.5f);
+    Color clouds_color(float noise_val) const {
         noise_val = (noise_val + 1.0f) * 0.5f; // Normaliza [0,1]
         
         Color sky_blue(0.5f, 0.7f, 1.0f);
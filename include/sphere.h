@@ -12,6 +12,7 @@ public:
     // NOVOS CAMPOS
     MaterialType mat_type;
     float fuzz;
+    int light = -1;     // Índice em scene.lights (LightSampler::build)
     
     // CONSTRUTOR ATUALIZADO: Agora aceita type e fuzz
     Sphere(Point3 c, float r, Color a, MaterialType type = DIFFUSE, float f = 0.0f, Color e = Color(0,0,0))
@@ -45,6 +46,8 @@ public:
         // ADICIONE ESTAS LINHAS PARA PASSAR A INFORMAÇÃO DO MATERIAL
         rec.mat_type = mat_type;
         rec.fuzz = fuzz;
+        rec.object_id = -1;
+        rec.light = light;
         
         return true;
     }
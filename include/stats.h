@@ -0,0 +1,205 @@
+#ifndef STATS_H
+#define STATS_H
+
+// Estatísticas do integrador (compilar com -DPT_STATS para ligar).
+//
+// Cada thread conta no seu RenderStats (thread_local) e, no fim de cada região
+// paralela de renderização, soma o que contou no total compartilhado
+// (PT_STATS_FLUSH); collect_render_stats() devolve esse total. Sem PT_STATS
+// as macros PT_STAT_* não geram código nenhum e o integrador fica idêntico.
+
+#ifdef PT_STATS
+
+#include <cstdio>
+#include <mutex>
+#include <chrono>
+#include <string>
+#include <fstream>
+#include <iostream>
+#include <iomanip>
+#include <algorithm>
+
+// Profundidades contadas separadamente (a última acumula as mais fundas)
+const int STATS_MAX_DEPTH = 16;
+
+// Primitiva atingida por Scene::hit
+enum StatHitKind { STAT_MISS = 0, STAT_SPHERE, STAT_PLANE, STAT_TRIANGLE };
+
+struct RenderStats {
+    unsigned long long rays_by_depth[STATS_MAX_DEPTH] = {};
+    unsigned long long hits_sphere = 0;
+    unsigned long long hits_plane = 0;
+    unsigned long long hits_triangle = 0;
+    unsigned long long misses = 0;
+    unsigned long long emitter_hits = 0;      // Caminhos encerrados numa luz
+    unsigned long long rr_terminations = 0;   // Caminhos encerrados pela roleta russa
+    unsigned long long metal_absorbed = 0;    // Reflexões do metal para dentro da superfície
+    unsigned long long shadow_rays = 0;       // Raios de sombra da luz direta
+    unsigned long long shadow_blocked = 0;    // ... que encontraram um obstáculo
+    unsigned long long textured_evals = 0;    // Avaliações da textura sólida (ao vivo)
+    unsigned long long baked_lookups = 0;     // Consultas ao cache de textura
+    unsigned long long paths = 0;             // Caminhos concluídos
+    unsigned long long path_vertices = 0;     // Soma dos raios lançados por caminho
+    unsigned long long intersect_ns = 0;      // Tempo em Scene::hit (+ diferenciais)
+    unsigned long long shade_ns = 0;          // Tempo em texturas e espalhamento
+    unsigned long long sort_ns = 0;           // Tempo ordenando raios (integrador em lote)
+
+    void merge(const RenderStats& o) {
+        for (int d = 0; d < STATS_MAX_DEPTH; d++) rays_by_depth[d] += o.rays_by_depth[d];
+        hits_sphere += o.hits_sphere;
+        hits_plane += o.hits_plane;
+        hits_triangle += o.hits_triangle;
+        misses += o.misses;
+        emitter_hits += o.emitter_hits;
+        rr_terminations += o.rr_terminations;
+        metal_absorbed += o.metal_absorbed;
+        shadow_rays += o.shadow_rays;
+        shadow_blocked += o.shadow_blocked;
+        textured_evals += o.textured_evals;
+        baked_lookups += o.baked_lookups;
+        paths += o.paths;
+        path_vertices += o.path_vertices;
+        intersect_ns += o.intersect_ns;
+        shade_ns += o.shade_ns;
+        sort_ns += o.sort_ns;
+    }
+
+    unsigned long long total_rays() const {
+        unsigned long long total = 0;
+        for (int d = 0; d < STATS_MAX_DEPTH; d++) total += rays_by_depth[d];
+        return total;
+    }
+
+    double average_path_length() const {
+        return paths ? static_cast<double>(path_vertices) / paths : 0.0;
+    }
+
+    void print(std::ostream& out) const {
+        unsigned long long rays = total_rays();
+        auto pct = [rays](unsigned long long v) { return rays ? 100.0 * v / rays : 0.0; };
+        double timed = static_cast<double>(intersect_ns + shade_ns + sort_ns);
+        auto time_pct = [timed](unsigned long long v) { return timed > 0 ? 100.0 * v / timed : 0.0; };
+
+        out << "---- Estatísticas do integrador ----" << std::endl;
+        out << std::fixed << std::setprecision(1);
+        out << "Raios por profundidade:" << std::endl;
+        for (int d = 0; d < STATS_MAX_DEPTH; d++) {
+            if (!rays_by_depth[d]) continue;
+            out << "  " << std::setw(2) << d << (d == STATS_MAX_DEPTH - 1 ? "+" : " ")
+                << std::setw(16) << rays_by_depth[d] << std::setw(8) << pct(rays_by_depth[d]) << "%" << std::endl;
+        }
+        out << "Acertos: esfera " << hits_sphere << " (" << pct(hits_sphere) << "%)"
+            << " | plano " << hits_plane << " (" << pct(hits_plane) << "%)"
+            << " | triângulo " << hits_triangle << " (" << pct(hits_triangle) << "%)"
+            << " | fundo " << misses << " (" << pct(misses) << "%)" << std::endl;
+        out << "Fim dos caminhos: luz " << emitter_hits << " | roleta russa " << rr_terminations
+            << " | absorvidos no metal " << metal_absorbed << " | fundo " << misses
+            << " | profundidade máxima " << (paths - std::min(paths, emitter_hits + rr_terminations + metal_absorbed + misses))
+            << std::endl;
+        out << "Luz direta: " << shadow_rays << " raios de sombra, " << shadow_blocked << " bloqueados ("
+            << (shadow_rays ? 100.0 * shadow_blocked / shadow_rays : 0.0) << "%)" << std::endl;
+        out << "Texturas: " << textured_evals << " avaliações, " << baked_lookups << " consultas ao cache" << std::endl;
+        out << std::setprecision(2) << "Caminhos: " << paths << " | comprimento médio "
+            << average_path_length() << " raios" << std::endl;
+        out << std::setprecision(1) << "Tempo: interseção " << intersect_ns / 1e6 << " ms (" << time_pct(intersect_ns) << "%)"
+            << " | shading " << shade_ns / 1e6 << " ms (" << time_pct(shade_ns) << "%)";
+        if (sort_ns) out << " | ordenação " << sort_ns / 1e6 << " ms (" << time_pct(sort_ns) << "%)";
+        out << std::endl << std::defaultfloat;
+    }
+
+    bool write_json(const std::string& path) const {
+        std::ofstream out(path);
+        if (!out) return false;
+        out << "{\n  \"rays_by_depth\": [";
+        for (int d = 0; d < STATS_MAX_DEPTH; d++) out << (d ? ", " : "") << rays_by_depth[d];
+        out << "],\n"
+            << "  \"rays\": " << total_rays() << ",\n"
+            << "  \"hits\": {\"sphere\": " << hits_sphere << ", \"plane\": " << hits_plane
+            << ", \"triangle\": " << hits_triangle << ", \"miss\": " << misses << "},\n"
+            << "  \"emitter_hits\": " << emitter_hits << ",\n"
+            << "  \"rr_terminations\": " << rr_terminations << ",\n"
+            << "  \"metal_absorbed\": " << metal_absorbed << ",\n"
+            << "  \"shadow_rays\": " << shadow_rays << ",\n"
+            << "  \"shadow_blocked\": " << shadow_blocked << ",\n"
+            << "  \"textured_evals\": " << textured_evals << ",\n"
+            << "  \"baked_lookups\": " << baked_lookups << ",\n"
+            << "  \"paths\": " << paths << ",\n"
+            << "  \"average_path_length\": " << average_path_length() << ",\n"
+            << "  \"intersect_ms\": " << intersect_ns / 1e6 << ",\n"
+            << "  \"shade_ms\": " << shade_ns / 1e6 << ",\n"
+            << "  \"sort_ms\": " << sort_ns / 1e6 << "\n}\n";
+        return static_cast<bool>(out);
+    }
+};
+
+inline thread_local RenderStats render_stats;
+
+// Total das threads que já terminaram as suas regiões de renderização
+inline std::mutex render_stats_mutex;
+inline RenderStats render_stats_total;
+
+// Soma os contadores da thread atual no total e zera os dela (chamar no fim
+// de cada região paralela que renderiza, por todas as threads da equipe)
+inline void flush_render_stats() {
+    std::lock_guard<std::mutex> lock(render_stats_mutex);
+    render_stats_total.merge(render_stats);
+    render_stats = RenderStats();
+}
+
+// Contadores somados desde a última chamada
+inline RenderStats collect_render_stats() {
+    std::lock_guard<std::mutex> lock(render_stats_mutex);
+    RenderStats total = render_stats_total;
+    render_stats_total = RenderStats();
+    return total;
+}
+
+// Soma ao contador o tempo decorrido até o fim do escopo
+class StatTimer {
+public:
+    explicit StatTimer(unsigned long long& target)
+        : target_(target), start_(std::chrono::steady_clock::now()) {}
+    ~StatTimer() { stop(); }
+
+    // Encerra a medição antes do fim do escopo
+    void stop() {
+        if (stopped_) return;
+        target_ += std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now() - start_).count();
+        stopped_ = true;
+    }
+private:
+    unsigned long long& target_;
+    std::chrono::steady_clock::time_point start_;
+    bool stopped_ = false;
+};
+
+#define PT_STATS_CONCAT_(a, b) a##b
+#define PT_STATS_CONCAT(a, b) PT_STATS_CONCAT_(a, b)
+
+#define PT_STAT_ADD(field, n) (render_stats.field += (n))
+#define PT_STAT_INC(field) (++render_stats.field)
+#define PT_STAT_RAY(depth) (++render_stats.rays_by_depth[(depth) < STATS_MAX_DEPTH ? (depth) : STATS_MAX_DEPTH - 1])
+#define PT_STAT_PATH(length) (++render_stats.paths, render_stats.path_vertices += (length))
+#define PT_STAT_HIT(kind)                                                      \
+    ((kind) == STAT_SPHERE   ? ++render_stats.hits_sphere :                    \
+     (kind) == STAT_PLANE    ? ++render_stats.hits_plane :                     \
+     (kind) == STAT_TRIANGLE ? ++render_stats.hits_triangle : ++render_stats.misses)
+#define PT_STAT_TIMER(field) StatTimer PT_STATS_CONCAT(pt_stat_timer_, __LINE__)(render_stats.field)
+#define PT_STATS_FLUSH() flush_render_stats()
+#define PT_STATS_ONLY(...) __VA_ARGS__
+
+#else
+
+#define PT_STAT_ADD(field, n) ((void)0)
+#define PT_STAT_INC(field) ((void)0)
+#define PT_STAT_RAY(depth) ((void)0)
+#define PT_STAT_PATH(length) ((void)0)
+#define PT_STAT_HIT(kind) ((void)0)
+#define PT_STAT_TIMER(field) ((void)0)
+#define PT_STATS_FLUSH() ((void)0)
+#define PT_STATS_ONLY(...)
+
+#endif
+
+#endif
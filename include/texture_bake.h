@@ -0,0 +1,110 @@
+#ifndef TEXTURE_BAKE_H
+#define TEXTURE_BAKE_H
+
+#include <vector>
+#include <cmath>
+#include <random>
+#include <algorithm>
+#include "vec3.h"
+#include "solid_texture.h"
+
+// Cache 3D de uma textura sólida: a textura é amostrada uma vez numa grade
+// regular sobre a caixa envolvente de um objeto e as consultas viram uma
+// interpolação trilinear (8 leituras) em vez de várias oitavas de Perlin.
+class BakedTexture3D {
+public:
+    Point3 bmin, bmax;
+    int nx = 0, ny = 0, nz = 0;   // Amostras por eixo (>= 2)
+    std::vector<Color> texels;
+
+    // Amostra 'type' em [bmin, bmax]; 'resolution' é o número de amostras no
+    // eixo mais longo e os demais eixos seguem a proporção da caixa.
+    void bake(const SolidTexture& tex, SolidTextureType type, Point3 lo, Point3 hi, int resolution) {
+        // Margem para que pontos na superfície do objeto caiam dentro da grade
+        Vec3 pad = (hi - lo) * 0.01f + Vec3(1e-4f, 1e-4f, 1e-4f);
+        bmin = lo - pad;
+        bmax = hi + pad;
+
+        Vec3 extent = bmax - bmin;
+        float longest = std::max({extent.x, extent.y, extent.z});
+        auto axis_res = [&](float e) {
+            return std::max(2, static_cast<int>(std::ceil(resolution * e / longest)));
+        };
+        nx = axis_res(extent.x);
+        ny = axis_res(extent.y);
+        nz = axis_res(extent.z);
+        texels.assign(static_cast<size_t>(nx) * ny * nz, Color(0, 0, 0));
+
+        // Cada fatia z é independente
+        #pragma omp parallel for schedule(dynamic)
+        for (int k = 0; k < nz; k++) {
+            for (int j = 0; j < ny; j++) {
+                for (int i = 0; i < nx; i++) {
+                    texels[index(i, j, k)] = tex.eval(type, texel_position(i, j, k));
+                }
+            }
+        }
+    }
+
+    bool contains(const Point3& p) const {
+        return p.x >= bmin.x && p.x <= bmax.x &&
+               p.y >= bmin.y && p.y <= bmax.y &&
+               p.z >= bmin.z && p.z <= bmax.z;
+    }
+
+    // Interpolação trilinear (pontos fora da caixa são presos à borda)
+    Color lookup(const Point3& p) const {
+        float fx = std::clamp((p.x - bmin.x) / (bmax.x - bmin.x), 0.0f, 1.0f) * (nx - 1);
+        float fy = std::clamp((p.y - bmin.y) / (bmax.y - bmin.y), 0.0f, 1.0f) * (ny - 1);
+        float fz = std::clamp((p.z - bmin.z) / (bmax.z - bmin.z), 0.0f, 1.0f) * (nz - 1);
+
+        int i = std::min(static_cast<int>(fx), nx - 2);
+        int j = std::min(static_cast<int>(fy), ny - 2);
+        int k = std::min(static_cast<int>(fz), nz - 2);
+        float tx = fx - i, ty = fy - j, tz = fz - k;
+
+        auto lerp = [](const Color& a, const Color& b, float t) { return a + (b - a) * t; };
+        Color c00 = lerp(texels[index(i, j,     k    )], texels[index(i + 1, j,     k    )], tx);
+        Color c10 = lerp(texels[index(i, j + 1, k    )], texels[index(i + 1, j + 1, k    )], tx);
+        Color c01 = lerp(texels[index(i, j,     k + 1)], texels[index(i + 1, j,     k + 1)], tx);
+        Color c11 = lerp(texels[index(i, j + 1, k + 1)], texels[index(i + 1, j + 1, k + 1)], tx);
+        return lerp(lerp(c00, c10, ty), lerp(c01, c11, ty), tz);
+    }
+
+    size_t memory_bytes() const {
+        return texels.size() * sizeof(Color);
+    }
+
+    // Erro da grade contra a textura ao vivo em 'samples' pontos aleatórios da caixa
+    void measure_error(const SolidTexture& tex, SolidTextureType type, int samples,
+                       float& rmse, float& max_error) const {
+        std::mt19937 gen(7);
+        std::uniform_real_distribution<float> u(0.0f, 1.0f);
+        double sum_sq = 0.0;
+        max_error = 0.0f;
+
+        for (int s = 0; s < samples; s++) {
+            Point3 p(bmin.x + u(gen) * (bmax.x - bmin.x),
+                     bmin.y + u(gen) * (bmax.y - bmin.y),
+                     bmin.z + u(gen) * (bmax.z - bmin.z));
+            Vec3 d = lookup(p) - tex.eval(type, p);
+            float e2 = (d.x * d.x + d.y * d.y + d.z * d.z) / 3.0f;
+            sum_sq += e2;
+            max_error = std::max({max_error, std::abs(d.x), std::abs(d.y), std::abs(d.z)});
+        }
+        rmse = static_cast<float>(std::sqrt(sum_sq / samples));
+    }
+
+private:
+    size_t index(int i, int j, int k) const {
+        return (static_cast<size_t>(k) * ny + j) * nx + i;
+    }
+
+    Point3 texel_position(int i, int j, int k) const {
+        return Point3(bmin.x + (bmax.x - bmin.x) * i / (nx - 1),
+                      bmin.y + (bmax.y - bmin.y) * j / (ny - 1),
+                      bmin.z + (bmax.z - bmin.z) * k / (nz - 1));
+    }
+};
+
+#endif
@@ -0,0 +1,184 @@
+#ifndef TIMELINE_H
+#define TIMELINE_H
+
+#include <cstdio>
+#include <cstdint>
+#include <cstdlib>
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <memory>
+#include <string>
+#include <vector>
+#include <fstream>
+#include <algorithm>
+
+// Linha do tempo das fases da renderização no formato Chrome trace (abre em
+// chrome://tracing ou ui.perfetto.dev): carga e normalização da cena,
+// build, blocos renderizados por thread, tonemap, codificação das imagens...
+//
+// Cada thread grava os seus eventos num buffer circular próprio, sem trava:
+// só a thread dona escreve. Quando o buffer enche os eventos mais antigos são
+// sobrescritos. A trava só é usada para registrar o buffer na primeira vez
+// que a thread grava e para exportar o JSON.
+//
+// Desligada (padrão), uma região marcada custa a leitura de um atomic.
+
+namespace timeline {
+
+// Eventos guardados por thread
+const size_t RING_SIZE = 1 << 15;
+
+struct Event {
+    const char* name;       // Literais: o buffer não copia strings
+    const char* category;
+    const char* arg_name;   // nullptr = sem argumento
+    int64_t arg;
+    int64_t start_ns;
+    int64_t duration_ns;
+};
+
+struct ThreadBuffer {
+    int tid = 0;
+    uint64_t written = 0;   // Total já gravado (o índice no anel é written % RING_SIZE)
+    std::vector<Event> events = std::vector<Event>(RING_SIZE);
+};
+
+struct State {
+    std::atomic<bool> enabled{false};
+    std::string path;
+    std::chrono::steady_clock::time_point origin;
+    std::mutex mutex;
+    std::vector<std::unique_ptr<ThreadBuffer>> buffers; // Sobrevivem às threads
+};
+
+inline State& state() {
+    static State s;
+    return s;
+}
+
+inline bool enabled() { return state().enabled.load(std::memory_order_relaxed); }
+
+inline int64_t now_ns() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now() - state().origin).count();
+}
+
+inline ThreadBuffer& thread_buffer() {
+    thread_local ThreadBuffer* buffer = nullptr;
+    if (!buffer) {
+        State& s = state();
+        std::lock_guard<std::mutex> lock(s.mutex);
+        s.buffers.push_back(std::make_unique<ThreadBuffer>());
+        buffer = s.buffers.back().get();
+        buffer->tid = static_cast<int>(s.buffers.size());
+    }
+    return *buffer;
+}
+
+inline void record(const char* name, const char* category, int64_t start_ns, int64_t duration_ns,
+                   const char* arg_name = nullptr, int64_t arg = 0) {
+    ThreadBuffer& buffer = thread_buffer();
+    buffer.events[buffer.written % RING_SIZE] = {name, category, arg_name, arg, start_ns, duration_ns};
+    buffer.written++;
+}
+
+// Grava o JSON com os eventos de todas as threads. Chamar com as threads de
+// renderização paradas (fim do programa).
+inline bool write(const std::string& path) {
+    State& s = state();
+    std::lock_guard<std::mutex> lock(s.mutex);
+    std::ofstream out(path);
+    if (!out) return false;
+
+    out << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+    bool first = true;
+    uint64_t dropped = 0;
+    char line[512];
+    for (const auto& buffer : s.buffers) {
+        std::snprintf(line, sizeof(line),
+                      "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,\"args\":{\"name\":\"thread %d\"}}",
+                      first ? "" : ",\n", buffer->tid, buffer->tid);
+        out << line;
+        first = false;
+
+        uint64_t count = std::min<uint64_t>(buffer->written, RING_SIZE);
+        dropped += buffer->written - count;
+        for (uint64_t k = buffer->written - count; k < buffer->written; k++) {
+            const Event& e = buffer->events[k % RING_SIZE];
+            int n = std::snprintf(line, sizeof(line),
+                                  ",\n{\"name\":\"%s\",\"cat\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%d,"
+                                  "\"ts\":%.3f,\"dur\":%.3f",
+                                  e.name, e.category, buffer->tid, e.start_ns / 1000.0, e.duration_ns / 1000.0);
+            if (e.arg_name && n > 0 && n < static_cast<int>(sizeof(line))) {
+                std::snprintf(line + n, sizeof(line) - n, ",\"args\":{\"%s\":%lld}",
+                              e.arg_name, static_cast<long long>(e.arg));
+            }
+            out << line << "}";
+        }
+    }
+    out << "\n]}\n";
+    if (dropped) {
+        std::fprintf(stderr, "AVISO: linha do tempo: %llu eventos antigos descartados (buffer cheio)\n",
+                     static_cast<unsigned long long>(dropped));
+    }
+    return static_cast<bool>(out);
+}
+
+// Liga a gravação; o JSON é escrito em 'path' quando o programa termina
+inline void start(const std::string& path) {
+    State& s = state();
+    s.path = path;
+    s.origin = std::chrono::steady_clock::now();
+    s.enabled = true;
+    std::atexit([] {
+        State& st = state();
+        st.enabled = false;
+        if (write(st.path)) {
+            std::printf("Linha do tempo salva em: %s\n", st.path.c_str());
+        } else {
+            std::fprintf(stderr, "AVISO: falha ao gravar a linha do tempo %s\n", st.path.c_str());
+        }
+    });
+}
+
+// Evento do tamanho do escopo
+class Scope {
+public:
+    Scope(const char* name, const char* category, const char* arg_name = nullptr, int64_t arg = 0)
+        : active_(enabled()) {
+        if (!active_) return;
+        name_ = name;
+        category_ = category;
+        arg_name_ = arg_name;
+        arg_ = arg;
+        start_ = now_ns();
+    }
+    ~Scope() { end(); }
+
+    // Encerra o evento antes do fim do escopo
+    void end() {
+        if (active_) record(name_, category_, start_, now_ns() - start_, arg_name_, arg_);
+        active_ = false;
+    }
+    Scope(const Scope&) = delete;
+    Scope& operator=(const Scope&) = delete;
+
+private:
+    bool active_;
+    const char* name_ = nullptr;
+    const char* category_ = nullptr;
+    const char* arg_name_ = nullptr;
+    int64_t arg_ = 0;
+    int64_t start_ = 0;
+};
+
+} // namespace timeline
+
+#define PT_TIMELINE_CONCAT_(a, b) a##b
+#define PT_TIMELINE_CONCAT(a, b) PT_TIMELINE_CONCAT_(a, b)
+
+// Marca o restante do escopo atual como um evento ("nome", "categoria"[, "arg", valor])
+#define PT_TIMELINE_SCOPE(...) timeline::Scope PT_TIMELINE_CONCAT(pt_timeline_scope_, __LINE__)(__VA_ARGS__)
+
+#endif
@@ -0,0 +1,130 @@
+#ifndef TONEMAP_H
+#define TONEMAP_H
+
+#include <cmath>
+#include <cstdint>
+#include <vector>
+#include <algorithm>
+#include "vec3.h"
+#include "simd.h"
+
+// Tonemap do framebuffer linear para RGB de 8 bits, em paralelo.
+//
+// O operador (exposição + curva) roda 8 canais por vez com AVX2. A curva de
+// transferência (gamma ou sRGB) não usa pow: uma tabela de 4096 entradas dá
+// o nível da borda inferior de cada intervalo e os limiares exatos de cada
+// um dos 256 níveis corrigem o resultado, então a saída é a mesma de
+// floor(curva(x) * 255) (a menos de arredondamento nos limiares).
+
+enum ToneOperator {
+    TONE_CLAMP = 0,     // Clamp em [0, 1] + gamma (saída original do renderizador)
+    TONE_SRGB,          // Clamp + curva sRGB
+    TONE_REINHARD,      // x / (1 + x) por canal + sRGB
+    TONE_ACES           // Ajuste do ACES filmic de Narkowicz + sRGB
+};
+
+class Tonemapper {
+public:
+    static constexpr int LUT_SIZE = 4096;
+
+    explicit Tonemapper(ToneOperator op = TONE_CLAMP, float exposure = 1.0f, float gamma = 2.2f)
+        : op_(op), exposure_(exposure) {
+        // Limiar de cada nível: menor valor linear (já em [0, 1]) que chega nele
+        for (int v = 0; v < 256; v++) {
+            double t = v / 255.0;
+            double linear;
+            if (op == TONE_CLAMP) {
+                linear = std::pow(t, static_cast<double>(gamma));
+            } else {
+                linear = t <= 0.04045 ? t / 12.92 : std::pow((t + 0.055) / 1.055, 2.4);
+            }
+            threshold_[v] = static_cast<float>(linear);
+        }
+        threshold_[256] = 2.0f; // Nunca alcançado: y <= 1
+
+        int level = 0;
+        for (int k = 0; k < LUT_SIZE; k++) {
+            float y = static_cast<float>(k) / (LUT_SIZE - 1);
+            while (y >= threshold_[level + 1]) level++;
+            lut_[k] = static_cast<uint8_t>(level);
+        }
+    }
+
+    // Curva do operador para um canal (já com a exposição), resultado em [0, 1]
+    float curve(float x) const {
+        x *= exposure_;
+        if (!(x > 0.0f)) return 0.0f; // Também descarta NaN
+        switch (op_) {
+            case TONE_REINHARD: x = x / (1.0f + x); break;
+            case TONE_ACES:     x = (x * (2.51f * x + 0.03f)) / (x * (2.43f * x + 0.59f) + 0.14f); break;
+            default: break;
+        }
+        return x < 1.0f ? x : 1.0f; // inf / inf (valores enormes) vira 1
+    }
+
+    // Valor em [0, 1] -> nível de 8 bits
+    uint8_t encode(float y) const {
+        int level = lut_[static_cast<int>(y * (LUT_SIZE - 1))];
+        while (y >= threshold_[level + 1]) level++;
+        return static_cast<uint8_t>(level);
+    }
+
+    // 'n' pixels de 'in' para RGB de 8 bits em 'out'
+    void apply(const Color* in, uint8_t* out, size_t n) const {
+        static_assert(sizeof(Color) == 3 * sizeof(float), "Color precisa ser 3 floats contíguos");
+        const float* src = &in[0].x;
+        const long long count = static_cast<long long>(n) * 3;
+        const long long CHUNK = 4096;
+
+        #pragma omp parallel for schedule(static)
+        for (long long c0 = 0; c0 < count; c0 += CHUNK) {
+            long long c1 = std::min(count, c0 + CHUNK);
+            long long i = c0;
+#ifdef PT_SIMD_AVX2
+            alignas(32) float y[8];
+            for (; i + 8 <= c1; i += 8) {
+                _mm256_store_ps(y, curve8(_mm256_loadu_ps(src + i)));
+                for (int k = 0; k < 8; k++) out[i + k] = encode(y[k]);
+            }
+#endif
+            for (; i < c1; i++) out[i] = encode(curve(src[i]));
+        }
+    }
+
+    std::vector<uint8_t> apply(const std::vector<Color>& in) const {
+        std::vector<uint8_t> out(in.size() * 3);
+        apply(in.data(), out.data(), in.size());
+        return out;
+    }
+
+private:
+    ToneOperator op_;
+    float exposure_;
+    float threshold_[257];
+    uint8_t lut_[LUT_SIZE];
+
+#ifdef PT_SIMD_AVX2
+    __m256 curve8(__m256 x) const {
+        const __m256 zero = _mm256_setzero_ps();
+        const __m256 one = _mm256_set1_ps(1.0f);
+        // max(x, 0) com o zero no segundo operando também troca NaN por 0
+        x = _mm256_max_ps(_mm256_mul_ps(x, _mm256_set1_ps(exposure_)), zero);
+        switch (op_) {
+            case TONE_REINHARD:
+                x = _mm256_div_ps(x, _mm256_add_ps(one, x));
+                break;
+            case TONE_ACES: {
+                __m256 num = _mm256_mul_ps(x, _mm256_fmadd_ps(_mm256_set1_ps(2.51f), x, _mm256_set1_ps(0.03f)));
+                __m256 den = _mm256_fmadd_ps(x, _mm256_fmadd_ps(_mm256_set1_ps(2.43f), x, _mm256_set1_ps(0.59f)),
+                                             _mm256_set1_ps(0.14f));
+                x = _mm256_div_ps(num, den);
+                break;
+            }
+            default: break;
+        }
+        return _mm256_min_ps(x, one); // NaN (inf / inf) vira 1, como no escalar
+    }
+#endif
+};
+
+#endif
@@ -0,0 +1,101 @@
+#ifndef TRIANGLE_BLOCK_H
+#define TRIANGLE_BLOCK_H
+
+#include <vector>
+#include <cstdint>
+#include "simd.h"
+#include "obj_loader.h"
+
+// Blocos de 8 triângulos em SoA para o teste de Möller–Trumbore vetorizado.
+// Guarda v0 e as arestas pré-calculadas; lanes vazias recebem um triângulo
+// degenerado (arestas nulas => det = 0), que nunca é atingido.
+struct alignas(32) TriangleBlock8 {
+    float v0x[8], v0y[8], v0z[8];
+    float e1x[8], e1y[8], e1z[8];
+    float e2x[8], e2y[8], e2z[8];
+    int index[8];       // Índice do triângulo original (-1 = lane vazia)
+
+    // Grava o triângulo 'tri' (índice 'i') na lane; sem 'tri', lane vazia
+    void set_lane(int lane, const Triangle* tri, int i) {
+        Vec3 v0, e1, e2;
+        index[lane] = -1;
+        if (tri) {
+            v0 = tri->v0;
+            e1 = tri->v1 - tri->v0;
+            e2 = tri->v2 - tri->v0;
+            index[lane] = i;
+        }
+        v0x[lane] = v0.x; v0y[lane] = v0.y; v0z[lane] = v0.z;
+        e1x[lane] = e1.x; e1y[lane] = e1.y; e1z[lane] = e1.z;
+        e2x[lane] = e2.x; e2y[lane] = e2.y; e2z[lane] = e2.z;
+    }
+
+#ifdef PT_SIMD_AVX2
+    // Retorna a lane do triângulo mais próximo em (t_min, t_max), ou -1.
+    // Em caso de acerto, 't_hit' recebe a distância.
+    int hit(const Vec3x8& orig, const Vec3x8& dir, float t_min, float t_max, float& t_hit) const {
+        Vec3x8 v0 = Vec3x8::load(v0x, v0y, v0z);
+        Vec3x8 e1 = Vec3x8::load(e1x, e1y, e1z);
+        Vec3x8 e2 = Vec3x8::load(e2x, e2y, e2z);
+
+        Vec3x8 pvec = Vec3x8::cross(dir, e2);
+        __m256 det = Vec3x8::dot(e1, pvec);
+
+        // |det| >= 1e-8 (o bit de sinal é removido com andnot)
+        __m256 abs_det = _mm256_andnot_ps(_mm256_set1_ps(-0.0f), det);
+        __m256 mask = _mm256_cmp_ps(abs_det, _mm256_set1_ps(1e-8f), _CMP_GE_OQ);
+
+        __m256 inv_det = _mm256_div_ps(_mm256_set1_ps(1.0f), det);
+        Vec3x8 tvec = orig - v0;
+        __m256 u = _mm256_mul_ps(Vec3x8::dot(tvec, pvec), inv_det);
+
+        Vec3x8 qvec = Vec3x8::cross(tvec, e1);
+        __m256 v = _mm256_mul_ps(Vec3x8::dot(dir, qvec), inv_det);
+        __m256 t = _mm256_mul_ps(Vec3x8::dot(e2, qvec), inv_det);
+
+        const __m256 zero = _mm256_setzero_ps();
+        const __m256 one = _mm256_set1_ps(1.0f);
+        mask = _mm256_and_ps(mask, _mm256_cmp_ps(u, zero, _CMP_GE_OQ));
+        mask = _mm256_and_ps(mask, _mm256_cmp_ps(u, one, _CMP_LE_OQ));
+        mask = _mm256_and_ps(mask, _mm256_cmp_ps(v, zero, _CMP_GE_OQ));
+        mask = _mm256_and_ps(mask, _mm256_cmp_ps(_mm256_add_ps(u, v), one, _CMP_LE_OQ));
+        mask = _mm256_and_ps(mask, _mm256_cmp_ps(t, _mm256_set1_ps(t_min), _CMP_GE_OQ));
+        mask = _mm256_and_ps(mask, _mm256_cmp_ps(t, _mm256_set1_ps(t_max), _CMP_LE_OQ));
+
+        int bits = _mm256_movemask_ps(mask);
+        if (bits == 0) return -1;
+
+        // Poucos acertos por bloco: a redução escalar é mais barata que um min horizontal
+        alignas(32) float ts[8];
+        _mm256_store_ps(ts, t);
+        int best = -1;
+        float best_t = t_max;
+        while (bits) {
+            int lane = __builtin_ctz(bits);
+            bits &= bits - 1;
+            if (ts[lane] <= best_t) {
+                best_t = ts[lane];
+                best = lane;
+            }
+        }
+        t_hit = best_t;
+        return best;
+    }
+#endif
+};
+
+// Empacota os triângulos em blocos de 8, na ordem em que aparecem
+inline std::vector<TriangleBlock8> build_triangle_blocks(const std::vector<Triangle>& triangles) {
+    std::vector<TriangleBlock8> blocks((triangles.size() + 7) / 8);
+
+    for (size_t b = 0; b < blocks.size(); b++) {
+        for (int lane = 0; lane < 8; lane++) {
+            size_t i = b * 8 + lane;
+            blocks[b].set_lane(lane, i < triangles.size() ? &triangles[i] : nullptr, static_cast<int>(i));
+        }
+    }
+
+    return blocks;
+}
+
+#endif
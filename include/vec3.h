@@ -48,4 +48,9 @@ inline Vec3 operator*(float t, const Vec3& v) {
     return v * t;
 }
 
+// Luminância (Rec. 709) de uma cor linear
+inline float luminance(const Color& c) {
+    return 0.2126f * c.x + 0.7152f * c.y + 0.0722f * c.z;
+}
+
 #endif
@@ -3,6 +3,16 @@
 #include <random>
 #include <cmath>
 #include <algorithm>  // Para std::clamp
+#include <string>
+#include <fstream>
+#include <sstream>
+#include <map>
+#include <memory>
+#include <filesystem>
+#include <cstdio>
+#include <cstdlib>
+#include <chrono>
+#include <thread>
 #include <omp.h>
 #include "../include/vec3.h"
 #include "../include/ray.h"
@@ -10,312 +20,1115 @@
 #include "../include/plane.h"
 #include "../include/obj_loader.h"
 #include "../include/solid_texture.h"
+#include "../include/scene.h"
+#include "../include/cornell_box.h"
+#include "../include/sampling.h"
+#include "../include/integrator.h"
+#include "../include/simd.h"
+#include "../include/camera.h"
+#include "../include/image_io.h"
+#include "../include/checkpoint.h"
+#include "../include/distributed.h"
+#include "../include/render_server.h"
+#include "../include/denoiser.h"
+#include "../include/stats.h"
+#include "../include/cost_map.h"
+#include "../include/timeline.h"
+#include "../include/tonemap.h"
+#include "../include/async_writer.h"
+#include "../include/animation.h"
+#include "../include/render_config.h"
 #include "../include/stb_image_write.h"
 
-#ifndef M_PI
-#define M_PI 3.14159265358979323846
-#endif
+// Configuração da renderização (render_config.h): padrões, --config <arquivo>
+// e chave=valor na linha de comando, preenchida no início de main()
+RenderConfig config;
 
+// Configurar cena Cornell Box ('fitted' recebe a transformação do OBJ)
+Scene setup_scene(const std::string& obj_path = "scenes/cornell_box.obj", MeshTransform* fitted = nullptr) {
+    Scene scene = load_cornell_box(obj_path, fitted);
+    if (scene.triangles.empty()) return scene;
+    
+    if (!config.environment.empty()) {
+        std::string error;
+        if (!scene.environment.load(config.environment, config.env_scale, config.env_rotation, error)) {
+            std::cerr << "ERRO: " << error << std::endl;
+            return Scene(); // Cena vazia = falha, como um OBJ que não carregou
+        }
+        std::cout << "Ambiente: " << config.environment << " (" << scene.environment.width() << "x"
+                  << scene.environment.height() << ")" << std::endl;
+    }
+    
+    if (config.texture_bake_res > 0) {
+        double bake_start = omp_get_wtime();
+        scene.bake_textures(config.texture_bake_res);
+        std::cout << "Tempo de pré-amostragem: " << (omp_get_wtime() - bake_start) << " segundos" << std::endl;
+    }
+    
+    return scene;
+}
 
-// Configurações de renderização
-const int WIDTH = 512;
-const int HEIGHT = 512;
-const int SAMPLES_PER_PIXEL = 800;
-const int MAX_DEPTH = 8;
-const int RR_DEPTH = 3;
-const float GAMMA = 2.2f;
+// Tonemap e grava o framebuffer em '<base>.png' e nos formatos HDR ligados
+void save_image(const std::vector<Color>& framebuffer, int width, int height, const std::string& base) {
+    // Tonemap e salvar PNG
+    std::vector<uint8_t> pixels;
+    {
+        PT_TIMELINE_SCOPE("tonemap", "saida");
+        // Sempre da configuração atual (montar as tabelas custa microssegundos)
+        const Tonemapper tonemapper(config.tone_operator, config.exposure, config.gamma);
+        pixels = tonemapper.apply(framebuffer);
+    }
+    
+    if (config.write_png) {
+        bool png_ok;
+        {
+            PT_TIMELINE_SCOPE("PNG", "saida");
+            png_ok = write_png(base + ".png", width, height, pixels.data(), config.png_compression);
+        }
+        if (png_ok) {
+            std::cout << "Imagem salva em: " << base << ".png" << std::endl;
+        } else {
+            std::cerr << "ERRO: não foi possível gravar " << base << ".png" << std::endl;
+        }
+    }
+    
+    // Framebuffer linear, antes do clamp e da correção gamma
+    PT_TIMELINE_SCOPE("HDR (PFM/HDR/EXR)", "saida");
+    if (config.write_pfm && write_pfm(base + ".pfm", width, height, framebuffer.data())) {
+        std::cout << "Imagem HDR salva em: " << base << ".pfm" << std::endl;
+    }
+    if (config.write_hdr && write_hdr(base + ".hdr", width, height, framebuffer.data())) {
+        std::cout << "Imagem HDR salva em: " << base << ".hdr" << std::endl;
+    }
+    if (config.write_exr && write_exr(base + ".exr", width, height, framebuffer.data(), config.exr_compression)) {
+        std::cout << "Imagem HDR salva em: " << base << ".exr" << std::endl;
+    }
+}
 
-// Gerador de números aleatórios thread-safe
-thread_local std::mt19937 rng(std::random_device{}());
-std::uniform_real_distribution<float> dist(0.0f, 1.0f);
+// Erro quadrático médio (raiz) entre duas imagens do mesmo tamanho. Com
+// 'display', compara os valores do PNG (clamp + gamma, em [0, 1]): a luz,
+// muito acima de 1, domina o erro linear sem mudar nada na tela.
+double rmse(const std::vector<Color>& a, const std::vector<Color>& b, bool display) {
+    auto tonemap = [](float v) { return std::pow(std::clamp(v, 0.0f, 1.0f), 1.0f / config.gamma); };
+    double sum = 0.0;
+    for (size_t i = 0; i < a.size(); i++) {
+        Vec3 d = a[i] - b[i];
+        if (display) {
+            d = Vec3(tonemap(a[i].x) - tonemap(b[i].x), tonemap(a[i].y) - tonemap(b[i].y),
+                     tonemap(a[i].z) - tonemap(b[i].z));
+        }
+        sum += d.x * d.x + d.y * d.y + d.z * d.z;
+    }
+    return std::sqrt(sum / (3.0 * a.size()));
+}
 
-float random_float() {
-    return dist(rng);
+// Estatísticas do integrador desde a última chamada (só com -DPT_STATS, ver
+// stats.h): tabela no console e '<base>_stats.json'
+void report_stats(const std::string& base) {
+#ifdef PT_STATS
+    RenderStats stats = collect_render_stats();
+    stats.print(std::cout);
+    if (stats.write_json(base + "_stats.json")) {
+        std::cout << "Estatísticas salvas em: " << base << "_stats.json" << std::endl;
+    }
+#else
+    (void)base;
+#endif
 }
 
-// Amostragem cosine-weighted hemisphere
-Vec3 cosine_sample_hemisphere(const Vec3& normal) {
-    float u1 = random_float();
-    float u2 = random_float();
+// Gravação das imagens (async_writer.h): na thread que chama, ou numa thread
+// própria com output_threads threads nos modos que ligam a sobreposição
+AsyncWriter& output_writer() {
+    static AsyncWriter writer(config.output_queue, config.output_threads);
+    return writer;
+}
+
+// Enfileira save_image para a thread de saída (o buffer volta para o pool)
+void save_image_async(std::vector<Color>&& framebuffer, int width, int height, const std::string& base) {
+    output_writer().submit(std::move(framebuffer), [width, height, base](const std::vector<Color>& image) {
+        save_image(image, width, height, base);
+    });
+}
+
+// Grava a imagem do buffer de acumulação em '<base>.*' e, se ligados, as AOVs
+// ('<base>_albedo.pfm', ...) e a imagem filtrada ('<base>_denoised.*').
+// Com 'reference' (PFM), imprime o erro contra ela. Com 'background' (imagem
+// inteira), os pixels sem amostras vêm dela, na imagem e na filtrada.
+// Com a sobreposição ligada, a gravação é assíncrona: chame output_writer().flush() para esperar os arquivos.
+void finish_image(const Checkpoint& accum, const std::string& base, const std::string& reference = "",
+                  const std::vector<Color>* background = nullptr) {
+    int width = accum.width, height = accum.height;
+    size_t n = static_cast<size_t>(width) * height;
+    std::vector<Color> framebuffer = output_writer().acquire(n);
+    accum.resolve(framebuffer);
+    
+    // Composição sobre a imagem anterior: tudo o que não foi renderizado agora
+    auto composite = [&](std::vector<Color>& image) {
+        if (!background) return;
+        for (int y = 0; y < height; y++) {
+            for (int x = 0; x < width; x++) {
+                bool inside = x >= accum.window_x && x < accum.window_x + accum.window_w &&
+                              y >= accum.window_y && y < accum.window_y + accum.window_h;
+                if (!inside || !accum.counts[accum.index(x, y)]) {
+                    size_t i = static_cast<size_t>(y) * width + x;
+                    image[i] = (*background)[i];
+                }
+            }
+        }
+    };
+    composite(framebuffer);
+    
+    if (!config.denoise && !config.write_aovs && reference.empty()) {
+        save_image_async(std::move(framebuffer), width, height, base);
+        return;
+    }
     
-    float r = std::sqrt(u1);
-    float theta = 2.0f * M_PI * u2;
+    std::vector<Color> albedo;
+    std::vector<Vec3> normal;
+    std::vector<float> depth, variance;
+    accum.resolve_aovs(albedo, normal, depth, variance);
+    
+    std::vector<Color> denoised;
+    if (config.denoise) {
+        double start = omp_get_wtime();
+        AtrousDenoiser denoiser;
+        {
+            PT_TIMELINE_SCOPE("denoiser", "saida");
+            denoised = denoiser.denoise(width, height, framebuffer.data(), albedo.data(), normal.data(),
+                                        depth.data(), variance.data());
+        }
+        composite(denoised);
+        std::cout << "Tempo do denoiser: " << (omp_get_wtime() - start) << " segundos" << std::endl;
+    }
     
-    float x = r * std::cos(theta);
-    float z = r * std::sin(theta);
-    float y = std::sqrt(std::max(0.0f, 1.0f - u1));
+    if (!reference.empty()) {
+        int ref_w = 0, ref_h = 0;
+        std::vector<Color> ref;
+        if (!read_pfm(reference, ref_w, ref_h, ref) || ref_w != width || ref_h != height) {
+            std::cerr << "AVISO: referência inválida ou de outro tamanho: " << reference << std::endl;
+        } else {
+            for (bool display : {false, true}) {
+                std::cout << "RMSE contra a referência (" << (display ? "tela" : "linear") << "): "
+                          << rmse(framebuffer, ref, display);
+                if (config.denoise) std::cout << " | com denoiser: " << rmse(denoised, ref, display);
+                std::cout << std::endl;
+            }
+        }
+    }
     
-    // Criar base ortonormal ao redor da normal
-    Vec3 tangent = std::abs(normal.x) > 0.1f ? Vec3(0, 1, 0) : Vec3(1, 0, 0);
-    tangent = Vec3::cross(normal, tangent).normalized();
-    Vec3 bitangent = Vec3::cross(normal, tangent);
+    save_image_async(std::move(framebuffer), width, height, base);
+    if (config.denoise) save_image_async(std::move(denoised), width, height, base + "_denoised");
     
-    return (tangent * x + normal * y + bitangent * z).normalized();
+    if (config.write_aovs) {
+        auto write_aov = [&](std::vector<Color>&& image, const std::string& name) {
+            std::string path = base + "_" + name + ".pfm";
+            output_writer().submit(std::move(image), [width, height, path](const std::vector<Color>& aov) {
+                PT_TIMELINE_SCOPE("AOV", "saida");
+                if (!write_pfm(path, width, height, aov.data())) {
+                    std::cerr << "AVISO: falha ao gravar " << path << std::endl;
+                }
+            });
+        };
+        auto gray = [&](const std::vector<float>& v) {
+            std::vector<Color> image = output_writer().acquire(v.size());
+            for (size_t i = 0; i < v.size(); i++) image[i] = Color(v[i], v[i], v[i]);
+            return image;
+        };
+        write_aov(std::move(albedo), "albedo");
+        write_aov(std::move(normal), "normal");
+        write_aov(gray(depth), "depth");
+        write_aov(gray(variance), "variance");
+        std::cout << "Gravando AOVs em: " << base << "_{albedo,normal,depth,variance}.pfm" << std::endl;
+    }
 }
 
-// Classe de cena
-class Scene {
-public:
-    std::vector<Sphere> spheres;
-    std::vector<Plane> planes;
-    std::vector<Triangle> triangles;
-    SolidTexture solid_tex;
-    
-    bool hit(const Ray& r, float t_min, float t_max, HitRecord& rec) const {
-        HitRecord temp_rec;
-        bool hit_anything = false;
-        float closest_so_far = t_max;
-        
-        for (const auto& sphere : spheres) {
-            if (sphere.hit(r, t_min, closest_so_far, temp_rec)) {
-                hit_anything = true;
-                closest_so_far = temp_rec.t;
-                rec = temp_rec;
-            }
+// Soma os checkpoints 'inputs' (imagens inteiras ou shards) em 'merged'
+bool merge_files(const std::vector<std::string>& inputs, Checkpoint& merged) {
+    std::vector<Checkpoint> headers; // Só os metadados, para detectar amostras repetidas
+    for (size_t i = 0; i < inputs.size(); i++) {
+        Checkpoint part;
+        if (!part.load(inputs[i])) {
+            std::cerr << "ERRO: checkpoint inválido: " << inputs[i] << std::endl;
+            return false;
         }
-        
-        for (const auto& plane : planes) {
-            if (plane.hit(r, t_min, closest_so_far, temp_rec)) {
-                hit_anything = true;
-                closest_so_far = temp_rec.t;
-                rec = temp_rec;
-            }
+        if (i == 0) {
+            merged.init(part.width, part.height, part.scene_hash, part.seed, part.pass_spp);
+            merged.first_pass = part.first_pass;
+        }
+        if (!merged.merge(part)) {
+            std::cerr << "ERRO: " << inputs[i] << " é de outra cena ou resolução" << std::endl;
+            return false;
         }
+        merged.first_pass = std::min(merged.first_pass, part.first_pass);
+        merged.passes_done = std::max(merged.passes_done, part.passes_done);
         
-        for (const auto& tri : triangles) {
-            if (tri.hit(r, t_min, closest_so_far, temp_rec)) {
-                hit_anything = true;
-                closest_so_far = temp_rec.t;
-                rec = temp_rec;
+        part.release_buffers();
+        for (const auto& h : headers) {
+            if (h.overlaps(part)) {
+                std::cerr << "AVISO: " << inputs[i] << " repete amostras de outro checkpoint (mesma semente e passadas)" << std::endl;
+                break;
             }
         }
-        
-        return hit_anything;
+        headers.push_back(part);
     }
-};
+    return !inputs.empty();
+}
 
-// Path tracing integrador
-Color trace(const Ray& r, const Scene& scene, int depth) {
-    // 1. Limite de recursão (profundidade máxima)
-    if (depth >= MAX_DEPTH) {
-        return Color(0, 0, 0);
-    }
+// Modo --merge: soma checkpoints de execuções separadas (sementes ou shards diferentes)
+int merge_checkpoints(const std::string& out_path, const std::vector<std::string>& inputs) {
+    Checkpoint merged;
+    if (!merge_files(inputs, merged)) return 1;
+    std::cout << "Mesclados " << inputs.size() << " checkpoints" << std::endl;
     
-    // 2. Interseção com a cena
-    HitRecord rec;
-    if (!scene.hit(r, 0.001f, 1e30f, rec)) {
-        // Cor de fundo (céu escuro para Cornell Box)
-        return Color(0.05f, 0.05f, 0.05f);
+    if (!merged.save(out_path)) {
+        std::cerr << "ERRO: não foi possível gravar " << out_path << std::endl;
+        return 1;
     }
+    std::cout << "Checkpoint mesclado salvo em: " << out_path << std::endl;
+    finish_image(merged, config.output);
+    return 0;
+}
+
+// Diferenciais para o vizinho a 1/sqrt(spp) pixel: com muitas amostras
+// por pixel cada uma cobre uma fração dele (mínimo de 1/8 de pixel). Entra
+// no hash da renderização, então abaixo de 64 spp mudar spp muda o hash.
+float differential_scale_for(int spp) {
+    return config.texture_lod ? std::max(0.125f, 1.0f / std::sqrt(static_cast<float>(spp))) : 0.0f;
+}
+
+// Uma passada de até pass_spp amostras (de um total de 'spp') sobre o bloco
+// [x0, x1) x [y0, y1) (linhas do framebuffer), acumulada em 'accum'.
+// Com sampler=stratified, as amostras de cada pixel na passada ocupam uma
+// grade n x n (n = raiz inteira das amostras da passada) com jitter; as que
+// sobram depois de n² voltam a ser uniformes.
+void render_pass(const Scene& scene, const Camera& camera, float differential_scale,
+                 Checkpoint& accum, int x0, int y0, int x1, int y1, int pass, int spp,
+                 CostMap* cost = nullptr) {
+    int pass_samples = std::min(config.pass_spp, spp - pass * config.pass_spp);
+    PT_TIMELINE_SCOPE("passada", "render", "pass", pass);
     
-    // 3. Se acertou uma luz (material emissivo), retorna a cor da luz
-    if (rec.emission.length() > 0.0f) {
-        return rec.emission;
+    #pragma omp parallel
+    {
+        const unsigned long long rays_start = rays_cast;
+        #pragma omp for schedule(dynamic)
+        for (int r = y0; r < y1; r++) {
+            PT_TIMELINE_SCOPE("linha", "render", "y", r);
+            int y = accum.height - 1 - r; // Linha da câmera (0 = base)
+            
+            // Sequência aleatória fixa por (semente, passada, linha, início do bloco):
+            // o mesmo bloco dá o mesmo resultado em qualquer processo
+            seed_rng(accum.seed, (static_cast<uint64_t>(pass) * accum.height + y) * accum.width + x0);
+            
+            // Amostras já geradas de cada pixel da linha nesta passada (estratificado)
+            thread_local std::vector<int> pixel_samples;
+            const int grid = static_cast<int>(std::sqrt(static_cast<float>(pass_samples)));
+            if (config.sampler == SAMPLER_STRATIFIED) pixel_samples.assign(x1 - x0, 0);
+            
+            auto camera_ray = [&](int x) {
+                if (config.sampler == SAMPLER_STRATIFIED) {
+                    int sample = pixel_samples[x - x0]++;
+                    if (sample < grid * grid) {
+                        float u = (sample % grid + random_float()) / grid;
+                        float v = (sample / grid + random_float()) / grid;
+                        return camera.get_ray(x + u, y + v, differential_scale);
+                    }
+                }
+                return camera.get_ray(x + random_float(), y + random_float(), differential_scale);
+            };
+            
+            size_t row_start = accum.index(x0, r);
+            Color* row = &accum.accum[row_start];
+            uint32_t* row_counts = &accum.counts[row_start];
+            
+            // AOVs do primeiro acerto, somadas junto com a cor
+            AovTarget aov;
+            aov.albedo = &accum.albedo[row_start];
+            aov.normal = &accum.normal[row_start];
+            aov.depth = &accum.depth[row_start];
+            aov.lum_sq = &accum.lum_sq[row_start];
+            
+            // Raios e tempo por pixel desta passada, para o mapa de custo
+            thread_local std::vector<uint32_t> row_rays;
+            thread_local std::vector<float> row_seconds;
+            double row_start_time = 0.0;
+            if (cost) {
+                row_rays.assign(x1 - x0, 0);
+                row_seconds.assign(x1 - x0, 0.0f);
+                aov.rays = row_rays.data();
+                row_start_time = omp_get_wtime();
+            }
+            
+            if (config.batched) {
+                // Linha inteira do bloco em lotes
+                trace_batched(scene, x1 - x0, pass_samples, config.batch_spp, config.sort_rays,
+                              [&](int i) { return camera_ray(x0 + i); }, row, aov);
+            } else {
+                for (int i = 0; i < x1 - x0; i++) {
+                    unsigned long long rays_before = rays_cast;
+                    double pixel_start = cost ? omp_get_wtime() : 0.0;
+                    for (int s = 0; s < pass_samples; s++) {
+                        FirstHit first;
+                        Color sample = trace(camera_ray(x0 + i), scene, 0, &first);
+                        row[i] = row[i] + sample;
+                        aov.add_first_hit(i, first);
+                        aov.add_sample(i, sample);
+                    }
+                    if (cost) {
+                        row_rays[i] = static_cast<uint32_t>(rays_cast - rays_before);
+                        row_seconds[i] = static_cast<float>(omp_get_wtime() - pixel_start);
+                    }
+                }
+            }
+            
+            if (cost) {
+                cost->add_row(x0, r, x1 - x0, row_rays.data(), config.batched ? nullptr : row_seconds.data(),
+                              pass_samples, omp_get_wtime() - row_start_time);
+            }
+            
+            for (int i = 0; i < x1 - x0; i++) {
+                row_counts[i] += pass_samples;
+            }
+        }
+        total_rays_cast += rays_cast - rays_start;
+        PT_STATS_FLUSH();
+    }
+}
+
+// Renderiza um shard num checkpoint parcial do tamanho do bloco.
+// 'on_pass' é chamado depois de cada passada.
+template <typename OnPass>
+Checkpoint render_shard(const Scene& scene, const Camera& camera, float differential_scale,
+                        uint64_t hash, uint64_t seed, const ShardSpec& shard, OnPass on_pass) {
+    Checkpoint part;
+    part.init_window(config.width, config.height, hash, seed, config.pass_spp,
+                     shard.x0, shard.y0, shard.x1 - shard.x0, shard.y1 - shard.y0);
+    part.first_pass = shard.pass_begin;
+    for (int pass = shard.pass_begin; pass < shard.pass_end; pass++) {
+        render_pass(scene, camera, differential_scale, part, shard.x0, shard.y0, shard.x1, shard.y1,
+                    pass, config.spp);
+        part.passes_done = pass + 1;
+        on_pass();
     }
+    return part;
+}
 
-    // 4. Otimização: Roleta Russa (Russian Roulette)
-    // Encerra caminhos aleatoriamente para economizar tempo em profundidades altas
-    if (depth >= RR_DEPTH) {
-        float p = std::max({rec.albedo.x, rec.albedo.y, rec.albedo.z});
-        p = std::clamp(p, 0.1f, 0.99f); // Probabilidade de continuar
+// Worker da fila: pega e renderiza shards até a fila esvaziar. O coordenador
+// também trabalha e, com a fila vazia, espera os shards dos outros processos
+// (devolvendo para a fila os de workers que pararam de responder).
+int run_queue(WorkQueue& queue, const Scene& scene, const Camera& camera, float differential_scale,
+              uint64_t hash, bool coordinator) {
+    Job job;
+    while (true) {
+        if (queue.claim(job, config.width, config.height, hash)) {
+            if (job.scene_hash != hash) {
+                std::cerr << "ERRO: a fila é de outra cena, resolução ou configuração" << std::endl;
+                queue.release(job);
+                return 1;
+            }
+            
+            double job_start = omp_get_wtime();
+            Checkpoint part = render_shard(scene, camera, differential_scale, hash, job.seed, job.shard,
+                                           [&] { queue.heartbeat(job); });
+            if (!queue.complete(job, part)) {
+                std::cerr << "ERRO: não foi possível gravar o resultado de " << job.name << std::endl;
+                queue.release(job);
+                return 1;
+            }
+            std::cout << job.name << " [" << job.shard.to_string() << "] concluído em "
+                      << (omp_get_wtime() - job_start) << " s" << std::endl;
+            continue;
+        }
+        
+        if (!coordinator) return 0;
+        if (static_cast<int>(queue.done_files().size()) >= queue.total_jobs()) return 0;
         
-        if (random_float() > p) {
-            return Color(0, 0, 0); // Caminho "morreu"
+        int requeued = queue.requeue_stale(config.stale_job_sec);
+        if (requeued > 0) {
+            std::cout << requeued << " trabalho(s) parado(s) devolvido(s) à fila" << std::endl;
         }
-        rec.albedo = rec.albedo / p; // Compensa a energia dos que sobreviveram
+        std::this_thread::sleep_for(std::chrono::milliseconds(200));
     }
+}
+
+// Modo --frames: renderiza a sequência em 'output/frame_NNNN.*'. A cena é
+// atualizada a cada quadro (refit ou rebuild da BVH) e a gravação de um
+// quadro acontece durante a renderização do seguinte. Tempos por quadro no
+// console e em 'output/frames.csv'.
+int render_animation(Scene& scene, const Camera& camera, float differential_scale, const Animation& animation,
+                     uint64_t seed) {
+    const int total_passes = (config.spp + config.pass_spp - 1) / config.pass_spp;
+    std::ofstream csv("output/frames.csv");
+    csv << "frame,update_ms,rebuild,sah_ratio,render_s\n";
     
-    // 5. VARIANTE 9: Aplicação de Textura Sólida
-    // Se o objeto foi marcado como TEXTURED (ex: caixas do OBJ), aplicamos a textura.
-    if (rec.mat_type == TEXTURED) {
-        // Você pode alternar entre wood, marble, etc.
-        rec.albedo = scene.solid_tex.wood(rec.p);
+    double total_update = 0.0, total_render = 0.0;
+    int rebuilds = 0;
+    output_writer().set_overlap(true); // Grava um quadro enquanto renderiza o próximo
+    double sequence_start = omp_get_wtime();
+    for (int frame = 0; frame < animation.frames; frame++) {
+        double update_start = omp_get_wtime();
+        if (!animation.pose(frame, scene.triangles)) {
+            std::cerr << "ERRO: não foi possível montar o quadro " << frame << std::endl;
+            return 1;
+        }
+        float quality = 1.0f;
+        bool rebuilt = scene.update(config.bvh_rebuild_threshold, &quality);
+        double update_time = omp_get_wtime() - update_start;
+        
+        double render_start = omp_get_wtime();
+        Checkpoint accum;
+        accum.init(config.width, config.height, 0, seed, config.pass_spp);
+        for (int pass = 0; pass < total_passes; pass++) {
+            render_pass(scene, camera, differential_scale, accum, 0, 0, config.width, config.height, pass, config.spp);
+        }
+        accum.passes_done = total_passes;
+        double render_time = omp_get_wtime() - render_start;
+        
+        char base[64];
+        std::snprintf(base, sizeof(base), "output/frame_%04d", frame);
+        finish_image(accum, base);
+        
+        total_update += update_time;
+        total_render += render_time;
+        rebuilds += rebuilt;
+        std::cout << "Quadro " << frame + 1 << "/" << animation.frames << ": atualização "
+                  << update_time * 1000.0 << " ms (" << (rebuilt ? "rebuild" : "refit") << ", SAH "
+                  << quality << "x) | renderização " << render_time << " s" << std::endl;
+        csv << frame << "," << update_time * 1000.0 << "," << rebuilt << "," << quality << "," << render_time << "\n";
     }
+    output_writer().flush();
+    
+    std::cout << "Sequência: " << animation.frames << " quadros em " << (omp_get_wtime() - sequence_start)
+              << " s | atualização total " << total_update * 1000.0 << " ms (" << rebuilds << " rebuilds)"
+              << " | renderização total " << total_render << " s" << std::endl;
+    return 0;
+}
 
-    // 6. Cálculo do Espalhamento (Scattering) baseado no Material
-    Ray scattered;
-    Vec3 scatter_direction;
+// Lê a lista de câmeras de '--cameras': uma por linha, com as chaves de
+// RenderJob::parse (cam=x,y,z target=x,y,z fov width height spp seed scene out).
+// As chaves ausentes vêm da configuração (RenderConfig). Linhas vazias e
+// começadas por '#' são ignoradas; sem 'out', a vista N vai para
+// 'output/view_N'.
+bool load_views(const std::string& path, std::vector<RenderJob>& views) {
+    std::ifstream in(path);
+    if (!in) {
+        std::cerr << "ERRO: não foi possível ler " << path << std::endl;
+        return false;
+    }
+    std::string line;
+    for (int number = 1; std::getline(in, line); number++) {
+        std::istringstream words(line);
+        std::vector<std::string> args;
+        for (std::string word; words >> word;) args.push_back(word);
+        if (args.empty() || args[0][0] == '#') continue;
+        
+        RenderJob view;
+        view.width = config.width;
+        view.height = config.height;
+        view.spp = config.spp;
+        view.seed = config.seed;
+        view.scene = config.scene;
+        view.cam_pos = config.cam_pos;
+        view.cam_target = config.cam_target;
+        view.fov = config.fov;
+        view.output.clear();
+        std::string error;
+        if (!view.parse(args, error)) {
+            std::cerr << "ERRO: " << path << ":" << number << ": " << error << std::endl;
+            return false;
+        }
+        if (view.output.empty()) view.output = "output/view_" + std::to_string(views.size());
+        views.push_back(view);
+    }
+    return !views.empty();
+}
 
-    if (rec.mat_type == METAL) {
-        // --- MATERIAL METÁLICO (Especular) ---
-        Vec3 reflected = Vec3::reflect(r.direction.normalized(), rec.normal);
+// Modo --cameras: renderiza todas as vistas. 'scene' é a cena já carregada
+// (config.scene); as outras cenas citadas pelas vistas são carregadas uma vez
+// cada e compartilhadas entre as vistas. Os blocos de todas as vistas entram
+// numa fila só (os mais caros primeiro), então as
+// threads passam de uma vista para a outra sem esperar; cada bloco faz todas
+// as passadas da sua vista. A thread que termina o último bloco de uma vista
+// grava a imagem enquanto as outras continuam renderizando.
+int render_views(const Scene& scene, const std::vector<RenderJob>& views) {
+    struct View {
+        const Scene* scene;
+        Camera camera;
+        float differential_scale;
+        Checkpoint accum;
+        std::string base;
+        int passes;
+        int remaining = 0;    // Blocos ainda não renderizados
+    };
+    struct Tile {
+        int view, x0, y0, x1, y1;
+        double cost;
+    };
+    
+    std::map<std::string, std::unique_ptr<Scene>> other_scenes;
+    std::vector<View> state;
+    std::vector<Tile> tiles;
+    state.reserve(views.size());
+    for (size_t v = 0; v < views.size(); v++) {
+        const RenderJob& job = views[v];
+        const Scene* view_scene = &scene;
+        if (job.scene != config.scene) {
+            auto& loaded = other_scenes[job.scene];
+            if (!loaded) {
+                loaded = std::make_unique<Scene>(setup_scene(job.scene));
+                if (loaded->triangles.empty()) return 1;
+            }
+            view_scene = loaded.get();
+        }
+        state.push_back({view_scene, Camera(job.cam_pos, job.cam_target, job.fov, job.width, job.height),
+                         differential_scale_for(job.spp), Checkpoint(), job.output,
+                         (job.spp + config.pass_spp - 1) / config.pass_spp, 0});
+        View& view = state.back();
+        view.accum.init(job.width, job.height, 0, job.seed, config.pass_spp);
+        view.accum.passes_done = view.passes;
+        std::filesystem::path base = job.output;
+        if (base.extension() == ".png") base.replace_extension();
+        std::error_code ec;
+        if (base.has_parent_path()) std::filesystem::create_directories(base.parent_path(), ec);
+        view.base = base.string();
         
-        // Adiciona rugosidade usando o parâmetro 'fuzz' do objeto
-        scatter_direction = (reflected + rec.fuzz * cosine_sample_hemisphere(rec.normal)).normalized();
+        for (int y = 0; y < job.height; y += config.tile_size) {
+            for (int x = 0; x < job.width; x += config.tile_size) {
+                Tile tile{static_cast<int>(v), x, y, std::min(x + config.tile_size, job.width),
+                          std::min(y + config.tile_size, job.height), 0.0};
+                tile.cost = static_cast<double>(tile.x1 - tile.x0) * (tile.y1 - tile.y0) * job.spp;
+                tiles.push_back(tile);
+                view.remaining++;
+            }
+        }
+    }
+    
+    // Mais caros primeiro: os blocos pequenos do fim equilibram as threads
+    std::stable_sort(tiles.begin(), tiles.end(), [](const Tile& a, const Tile& b) { return a.cost > b.cost; });
+    std::cout << views.size() << " vistas, " << (other_scenes.size() + 1) << " cenas, " << tiles.size() << " blocos" << std::endl;
+    
+    output_writer().set_overlap(true); // Grava uma vista enquanto as outras renderizam
+    double start_time = omp_get_wtime();
+    const int count = static_cast<int>(tiles.size());
+    #pragma omp parallel for schedule(dynamic, 1)
+    for (int t = 0; t < count; t++) {
+        const Tile& tile = tiles[t];
+        View& view = state[tile.view];
+        const RenderJob& job = views[tile.view];
+        // render_pass abre uma região paralela; aqui dentro ela roda só nesta thread
+        for (int pass = 0; pass < view.passes; pass++) {
+            render_pass(*view.scene, view.camera, view.differential_scale, view.accum,
+                        tile.x0, tile.y0, tile.x1, tile.y1, pass, job.spp);
+        }
         
-        // Se o raio refletido for para dentro da superfície, ele é absorvido
-        if (Vec3::dot(scatter_direction, rec.normal) <= 0.0f) {
-            return Color(0, 0, 0);
+        int remaining;
+        #pragma omp atomic capture
+        remaining = --view.remaining;
+        if (remaining == 0) {
+            #pragma omp critical(view_output)
+            {
+                std::cout << "Vista " << tile.view << " (" << job.width << "x" << job.height << ", " << job.spp
+                          << " spp) pronta em " << (omp_get_wtime() - start_time) << " s" << std::endl;
+                finish_image(view.accum, view.base);
+            }
         }
-    } else {
-        // --- MATERIAL DIFUSO / TEXTURIZADO (Lambertiano) ---
-        // Amostragem cosseno para iluminação global suave
-        scatter_direction = cosine_sample_hemisphere(rec.normal);
     }
-
-    // Gera o novo raio e continua o rastreamento recursivo
-    scattered = Ray(rec.p, scatter_direction);
-    Color incoming = trace(scattered, scene, depth + 1);
-
-    // Equação de Renderização simplificada: Cor = Albedo * Luz Recebida
-    return rec.albedo * incoming;
+    output_writer().flush();
+    std::cout << "Tempo de renderização: " << (omp_get_wtime() - start_time) << " segundos" << std::endl;
+    return 0;
 }
 
-// Configurar cena Cornell Box
-Scene setup_scene() {
-    Scene scene;
+// Modo --crop / --dirty-mask: renderiza só os blocos 'tiles' (todas as
+// passadas) e grava a imagem inteira, com o resto preto ou, com
+// 'background_path', vindo da imagem anterior. O checkpoint não é gravado.
+// O tempo de traçado é proporcional à área dos blocos.
+int render_region(const Scene& scene, const Camera& camera, float differential_scale, uint64_t hash, uint64_t seed,
+                  const std::vector<ShardSpec>& tiles, const std::string& background_path,
+                  const std::string& reference) {
+    if (tiles.empty()) {
+        std::cout << "Região vazia: nada a renderizar" << std::endl;
+        return 0;
+    }
+    
+    std::vector<Color> background;
+    if (!background_path.empty()) {
+        int bg_w = 0, bg_h = 0;
+        if (!read_pfm(background_path, bg_w, bg_h, background) || bg_w != config.width || bg_h != config.height) {
+            std::cerr << "ERRO: imagem de fundo inválida ou de outro tamanho: " << background_path << std::endl;
+            return 1;
+        }
+    }
     
-    // 1. Carrega O ARQUIVO DO PROFESSOR completo (paredes + caixas)
-    auto mesh = OBJLoader::load("scenes/cornell_box.obj");
+    // Buffer só da caixa que envolve os blocos
+    int x0 = config.width, y0 = config.height, x1 = 0, y1 = 0;
+    long long pixels = 0;
+    for (const auto& tile : tiles) {
+        x0 = std::min(x0, tile.x0); y0 = std::min(y0, tile.y0);
+        x1 = std::max(x1, tile.x1); y1 = std::max(y1, tile.y1);
+        pixels += static_cast<long long>(tile.x1 - tile.x0) * (tile.y1 - tile.y0);
+    }
+    Checkpoint accum;
+    accum.init_window(config.width, config.height, hash, seed, config.pass_spp, x0, y0, x1 - x0, y1 - y0);
+    accum.passes_done = tiles[0].pass_end;
+    std::cout << "Região: " << tiles.size() << " blocos, " << pixels << " pixels ("
+              << (100.0 * pixels / (static_cast<double>(config.width) * config.height)) << "% da imagem)" << std::endl;
     
-    if (mesh.empty()) {
-        std::cerr << "ERRO: Malha vazia! Verifique o caminho do arquivo." << std::endl;
-        return scene;
+    double start_time = omp_get_wtime();
+    const int count = static_cast<int>(tiles.size());
+    #pragma omp parallel for schedule(dynamic, 1)
+    for (int t = 0; t < count; t++) {
+        const ShardSpec& tile = tiles[t];
+        // render_pass abre uma região paralela; aqui dentro ela roda só nesta thread
+        for (int pass = tile.pass_begin; pass < tile.pass_end; pass++) {
+            render_pass(scene, camera, differential_scale, accum, tile.x0, tile.y0, tile.x1, tile.y1,
+                        pass, config.spp);
+        }
     }
-
-    // 2. Lógica de Normalização (Auto-Scale)
-    // A Cornell Box original vai de 0 a 555. Queremos converter para -1 a 1 (tamanho 2).
+    std::cout << "Tempo de renderização: " << (omp_get_wtime() - start_time) << " segundos" << std::endl;
     
-    // Encontra os limites (Bounding Box)
-    float min_x = 1e9, max_x = -1e9;
-    float min_y = 1e9, max_y = -1e9;
-    float min_z = 1e9, max_z = -1e9;
+    finish_image(accum, config.output, reference, background.empty() ? nullptr : &background);
+    output_writer().flush();
+    return 0;
+}
+
+// Bloco [x0, x1) x [y0, y1) com as passadas [0, passes)
+ShardSpec region_tile(int x0, int y0, int x1, int y1, int passes) {
+    ShardSpec tile;
+    tile.x0 = x0;
+    tile.y0 = y0;
+    tile.x1 = x1;
+    tile.y1 = y1;
+    tile.pass_begin = 0;
+    tile.pass_end = passes;
+    return tile;
+}
 
-    for (const auto& tri : mesh) {
-        for (const auto& v : {tri.v0, tri.v1, tri.v2}) {
-            if (v.x < min_x) min_x = v.x; if (v.x > max_x) max_x = v.x;
-            if (v.y < min_y) min_y = v.y; if (v.y > max_y) max_y = v.y;
-            if (v.z < min_z) min_z = v.z; if (v.z > max_z) max_z = v.z;
+// Blocos de region_tile pixels dentro do retângulo [x0, x1) x [y0, y1)
+std::vector<ShardSpec> crop_tiles(int x0, int y0, int x1, int y1, int passes) {
+    std::vector<ShardSpec> tiles;
+    for (int y = y0; y < y1; y += config.region_tile) {
+        for (int x = x0; x < x1; x += config.region_tile) {
+            tiles.push_back(region_tile(x, y, std::min(x + config.region_tile, x1), std::min(y + config.region_tile, y1), passes));
         }
     }
+    return tiles;
+}
 
-    // Calcula o centro e a escala
-    float center_x = (min_x + max_x) / 2.0f;
-    float center_y = min_y; // Base no 0
-    float center_z = (min_z + max_z) / 2.0f;
-    
-    // A sala tem ~555 de altura. Queremos altura ~2.0 na cena.
-    float max_dim = max_y - min_y; 
-    float scale = 2.0f / max_dim; 
+// Blocos da grade de region_tile pixels com algum pixel marcado na máscara
+// (PFM do tamanho da imagem; marcado = algum canal > 0)
+bool dirty_tiles(const std::string& mask_path, int passes, std::vector<ShardSpec>& tiles) {
+    int mask_w = 0, mask_h = 0;
+    std::vector<Color> mask;
+    if (!read_pfm(mask_path, mask_w, mask_h, mask) || mask_w != config.width || mask_h != config.height) {
+        std::cerr << "ERRO: máscara inválida ou de outro tamanho: " << mask_path << std::endl;
+        return false;
+    }
+    for (const ShardSpec& tile : crop_tiles(0, 0, config.width, config.height, passes)) {
+        bool dirty = false;
+        for (int y = tile.y0; y < tile.y1 && !dirty; y++) {
+            for (int x = tile.x0; x < tile.x1 && !dirty; x++) {
+                const Color& m = mask[static_cast<size_t>(y) * config.width + x];
+                dirty = m.x > 0.0f || m.y > 0.0f || m.z > 0.0f;
+            }
+        }
+        if (dirty) tiles.push_back(tile);
+    }
+    return true;
+}
 
-    std::cout << "Escalando cena... Fator: " << scale << std::endl;
+// Inicia 'count' workers locais em segundo plano (saída em <fila>/worker_N.log)
+void spawn_workers(const std::string& exe, const std::string& queue_dir, int count) {
+    for (int i = 0; i < count; i++) {
+        std::string log = queue_dir + "/worker_" + std::to_string(i) + ".log";
+#ifdef _WIN32
+        std::string cmd = "start \"\" /b \"" + exe + "\" --worker \"" + queue_dir + "\" > \"" + log + "\" 2>&1";
+#else
+        std::string cmd = "\"" + exe + "\" --worker \"" + queue_dir + "\" > \"" + log + "\" 2>&1 &";
+#endif
+        if (std::system(cmd.c_str()) != 0) {
+            std::cerr << "AVISO: não foi possível iniciar o worker " << i << std::endl;
+        }
+    }
+}
 
-    // Aplica a transformação em todos os triângulos carregados
-    for (auto& tri : mesh) {
-        auto transform = [&](Point3& p) {
-            p.x = (p.x - center_x) * scale;
-            p.y = (p.y - center_y) * scale;
-            p.z = (p.z - center_z) * scale;
-            
-            // Opcional: Girar 180 graus se a sala estiver de costas
-            // (A Cornell box original olha para +Z, nossa câmera olha para -Z ou vice versa)
-            // Experimente descomentar se vir tudo preto:
-            p.x = -p.x; 
-            p.z = -p.z; 
-        };
+// Modo --serve: mantém as cenas carregadas entre trabalhos (ver render_server.h)
+int serve(const std::string& socket_path) {
+#ifdef _WIN32
+    std::cerr << "ERRO: o modo servidor usa sockets Unix e só está disponível em sistemas POSIX" << std::endl;
+    (void)socket_path;
+    return 1;
+#else
+    RenderServer server;
+    if (!server.listen(socket_path)) {
+        std::cerr << "ERRO: não foi possível abrir o socket " << socket_path << std::endl;
+        return 1;
+    }
+    std::cout << "Servidor aguardando trabalhos em " << socket_path << std::endl;
+    
+    // Cenas já carregadas, por arquivo .obj (só a thread de renderização acessa)
+    std::map<std::string, std::unique_ptr<Scene>> scenes;
+    
+    server.run([&](const RenderJob& job, const std::atomic<bool>& cancelled, std::string& error) {
+        std::unique_ptr<Scene>& scene = scenes[job.scene];
+        if (!scene) {
+            scene = std::make_unique<Scene>(setup_scene(job.scene));
+            if (scene->triangles.empty()) {
+                scenes.erase(job.scene);
+                error = "cena vazia: " + job.scene;
+                return false;
+            }
+        }
         
-        transform(tri.v0);
-        transform(tri.v1);
-        transform(tri.v2);
+        Camera camera(job.cam_pos, job.cam_target, job.fov, job.width, job.height);
+        float differential_scale = differential_scale_for(job.spp);
         
-        // Recalcula normal
-        Vec3 e1 = tri.v1 - tri.v0;
-        Vec3 e2 = tri.v2 - tri.v0;
-        tri.normal = Vec3::cross(e1, e2).normalized();
+        Checkpoint accum;
+        accum.init(job.width, job.height, 0, job.seed, config.pass_spp);
+        int passes = (job.spp + config.pass_spp - 1) / config.pass_spp;
+        for (int pass = 0; pass < passes; pass++) {
+            if (cancelled) return true;
+            render_pass(*scene, camera, differential_scale, accum, 0, 0, job.width, job.height, pass, job.spp);
+        }
         
-        // Adiciona à cena
-        scene.triangles.push_back(tri);
-    }
-
-    // 3. Adiciona a Luz e Objetos Extras
-    // Como escalamos tudo para tamanho 2.0, a luz deve ficar perto de y=1.98
-    scene.spheres.push_back(Sphere(Point3(0, 1.98f, 0), 0.25f, Color(0,0,0), DIFFUSE, 0.0f, Color(15,15,15)));
-    
-    // Esfera Metálica (Exemplo extra, já que o OBJ já tem as caixas)
-    // Posicionada levemente à frente
-    scene.spheres.push_back(Sphere(Point3(0.4f, 0.4f, -0.4f), 0.4f, Color(0.8f, 0.8f, 0.8f), METAL, 0.05f));
+        std::filesystem::path base = job.output;
+        if (base.extension() == ".png") base.replace_extension();
+        std::error_code ec;
+        if (base.has_parent_path()) std::filesystem::create_directories(base.parent_path(), ec);
+        report_stats(base.string());
+        finish_image(accum, base.string());
+        output_writer().flush(); // Trabalho concluído = arquivos no disco
+        return true;
+    });
+    return 0;
+#endif
+}
 
-    return scene;
+// Valida a configuração e aplica as partes globais (integrador, threads)
+bool apply_config() {
+    std::string error;
+    if (!config.validate(error)) {
+        std::cerr << "ERRO: configuração inválida: " << error << std::endl;
+        return false;
+    }
+    integrator_settings = config.integrator;
+    if (config.threads > 0) omp_set_num_threads(config.threads);
+    return true;
 }
 
-int main() {
-    std::cout << "Iniciando renderização Path Tracing (Variante 9 - Texturas Sólidas)..." << std::endl;
-    std::cout << "Resolução: " << WIDTH << "x" << HEIGHT << std::endl;
-    std::cout << "Samples: " << SAMPLES_PER_PIXEL << " | Max Depth: " << MAX_DEPTH << std::endl;
+int main(int argc, char** argv) {
+    // Espera a thread de saída gravar tudo antes de sair de main (por qualquer return)
+    struct FlushOutput { ~FlushOutput() { output_writer().flush(); } } flush_output;
     
-    Scene scene = setup_scene();
+    // Linha de comando:
+    //   --config <arquivo>       lê a configuração de um arquivo de trabalho (render_config.h)
+    //   chave=valor              muda uma chave da configuração, ex: width=640 spp=256 max_depth=12
+    //                            threads=8 sampler=stratified out=output/teste (na ordem; o último vence).
+    //                            Só grava o PNG; pfm=1 hdr=1 exr=1 denoise=1 aovs=1 ligam o resto
+    //                            e checkpoint=1 grava <out>.ptck
+    //   --checkpoint <arquivo>   grava o checkpoint neste arquivo (com checkpoint=1 sem
+    //                            --checkpoint, em <out>.ptck; sem nenhum dos dois, não grava)
+    //   --resume                 continua a partir do checkpoint (com texture_lod=1, só muda spp
+    //                            se os dois valores forem >= 64: abaixo disso o LOD das texturas muda)
+    //   --seed <n>               semente do amostrador (use sementes diferentes para mesclar)
+    //   --merge <saida> <entradas...>  soma checkpoints e grava a imagem final
+    //   --reference <arquivo.pfm>  imprime o erro (RMSE) da imagem contra uma referência
+    //   --cost-map               grava o custo de cada pixel em <out>_cost.{png,pfm}
+    //   --timeline <arquivo.json>  grava a linha do tempo das fases (Chrome trace / Perfetto);
+    //                              vale para os modos que vêm depois dele na linha de comando
+    //
+    // Animação (ver animation.h), quadros em output/frame_NNNN.*:
+    //   --frames <n>               renderiza n quadros
+    //   --spin <objeto>,<graus>    gira o objeto (grupo usemtl, 0 = primeiro) por quadro; repetível
+    //   --mesh-sequence <padrão>   OBJ de cada quadro, ex: scenes/anim/f_%04d.obj
+    //
+    // Região (a imagem inteira é gravada; o checkpoint não):
+    //   --crop x0,y0,x1,y1         renderiza só o retângulo [x0,x1)x[y0,y1) (y a partir do topo)
+    //   --dirty-mask <mask.pfm>    renderiza só os blocos com pixels marcados (> 0) na máscara
+    //   --composite <anterior.pfm> fora da região, usa a imagem anterior (gravada com pfm=1) em vez de preto
+    //
+    //   --cameras <arquivo>        renderiza várias vistas, uma por linha (chaves ausentes vêm da configuração):
+    //                              cam=0,1,3 target=0,1,0 fov=40 width=512 height=512 spp=64 scene=... out=output/a
+    //
+    // Renderização distribuída (ver distributed.h):
+    //   --shard x0,y0,x1,y1,p0,p1  renderiza só o bloco [x0,x1)x[y0,y1) nas
+    //                              passadas [p0,p1) e grava em --checkpoint
+    //   --queue <dir>              coordenador: cria a fila, trabalha nela e
+    //                              mescla os shards no final
+    //   --tiles <CxR>              blocos da fila (padrão 4x4)
+    //   --sample-shards <n>        divide as passadas de cada bloco em n shards
+    //   --spawn <n>                inicia n workers locais junto com o coordenador
+    //   --worker <dir>             worker: renderiza shards da fila até ela esvaziar, com a
+    //                              configuração do coordenador (<dir>/config.txt)
+    //
+    // Servidor (POSIX, ver render_server.h):
+    //   --serve <socket>           mantém as cenas na memória e atende trabalhos
+    //   --submit <socket> <cmd...> envia um comando ao servidor, ex:
+    //                              --submit /tmp/pt.sock render width=256 height=256 spp=32 out=output/a.png wait=1
+    std::string checkpoint_path; // Padrão: <out>.ptck
+    bool resume = false;
+    bool cost_map = false;
+    std::string shard_text, queue_dir, worker_dir, reference, cameras_path;
+    std::string crop_text, dirty_mask, composite_path;
+    int tiles_x = 4, tiles_y = 4, sample_shards = 1, spawn = 0;
+    Animation animation;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--checkpoint" && i + 1 < argc) {
+            checkpoint_path = argv[++i];
+            config.checkpoint = true;
+        } else if (arg == "--reference" && i + 1 < argc) {
+            reference = argv[++i];
+        } else if (arg == "--resume") {
+            resume = true;
+            config.checkpoint = true;
+        } else if (arg == "--cost-map") {
+            cost_map = true;
+        } else if (arg == "--timeline" && i + 1 < argc) {
+            timeline::start(argv[++i]);
+        } else if (arg == "--crop" && i + 1 < argc) {
+            crop_text = argv[++i];
+        } else if (arg == "--dirty-mask" && i + 1 < argc) {
+            dirty_mask = argv[++i];
+        } else if (arg == "--composite" && i + 1 < argc) {
+            composite_path = argv[++i];
+        } else if (arg == "--cameras" && i + 1 < argc) {
+            cameras_path = argv[++i];
+        } else if (arg == "--frames" && i + 1 < argc) {
+            animation.frames = std::stoi(argv[++i]);
+        } else if (arg == "--spin" && i + 1 < argc) {
+            ObjectSpin spin;
+            if (std::sscanf(argv[++i], "%d,%f", &spin.object_id, &spin.degrees_per_frame) != 2) {
+                std::cerr << "ERRO: --spin espera <objeto>,<graus>: " << argv[i] << std::endl;
+                return 1;
+            }
+            animation.spins.push_back(spin);
+        } else if (arg == "--mesh-sequence" && i + 1 < argc) {
+            animation.mesh_sequence = argv[++i];
+        } else if (arg == "--seed" && i + 1 < argc) {
+            config.seed = std::stoull(argv[++i]);
+        } else if (arg == "--config" && i + 1 < argc) {
+            std::string error;
+            if (!config.load(argv[++i], error)) {
+                std::cerr << "ERRO: " << error << std::endl;
+                return 1;
+            }
+        } else if (arg.find('=') != std::string::npos && arg.compare(0, 2, "--") != 0) {
+            std::string error;
+            if (!config.set(arg, error)) {
+                std::cerr << "ERRO: " << error << std::endl;
+                return 1;
+            }
+        } else if (arg == "--merge" && i + 2 < argc) {
+            std::string out = argv[++i];
+            if (!apply_config()) return 1;
+            return merge_checkpoints(out, std::vector<std::string>(argv + i + 1, argv + argc));
+        } else if (arg == "--shard" && i + 1 < argc) {
+            shard_text = argv[++i];
+        } else if (arg == "--queue" && i + 1 < argc) {
+            queue_dir = argv[++i];
+        } else if (arg == "--tiles" && i + 1 < argc && std::sscanf(argv[i + 1], "%dx%d", &tiles_x, &tiles_y) == 2) {
+            i++;
+        } else if (arg == "--sample-shards" && i + 1 < argc) {
+            sample_shards = std::stoi(argv[++i]);
+        } else if (arg == "--spawn" && i + 1 < argc) {
+            spawn = std::stoi(argv[++i]);
+        } else if (arg == "--worker" && i + 1 < argc) {
+            // A configuração vem da fila; chaves depois de --worker ainda valem (ex: threads=4)
+            worker_dir = argv[++i];
+            std::string error;
+            if (!config.load(WorkQueue(worker_dir).config_path().string(), error)) {
+                std::cerr << "ERRO: " << error << std::endl;
+                return 1;
+            }
+        } else if (arg == "--serve" && i + 1 < argc) {
+            if (!apply_config()) return 1;
+            return serve(argv[i + 1]);
+        } else if (arg == "--submit" && i + 2 < argc) {
+#ifdef _WIN32
+            std::cerr << "ERRO: o modo servidor só está disponível em sistemas POSIX" << std::endl;
+            return 1;
+#else
+            std::string line;
+            for (int j = i + 2; j < argc; j++) line += std::string(j > i + 2 ? " " : "") + argv[j];
+            return submit_command(argv[i + 1], line);
+#endif
+        } else {
+            std::cerr << "Argumento desconhecido: " << arg << std::endl;
+            return 1;
+        }
+    }
+    
+    if (!apply_config()) return 1;
+    if (checkpoint_path.empty()) checkpoint_path = config.output + ".ptck";
+    {
+        std::filesystem::path out_dir = std::filesystem::path(config.output).parent_path();
+        std::error_code ec;
+        if (!out_dir.empty()) std::filesystem::create_directories(out_dir, ec);
+    }
     
-    // Buffer de imagem
-    std::vector<Color> framebuffer(WIDTH * HEIGHT);
+    std::cout << "Iniciando renderização Path Tracing (Variante 9 - Texturas Sólidas)..." << std::endl;
+    std::cout << "Resolução: " << config.width << "x" << config.height << std::endl;
+    std::cout << "Samples: " << config.spp << " | Max Depth: " << integrator_settings.max_depth << std::endl;
+    
+    MeshTransform mesh_transform;
+    Scene scene = setup_scene(config.scene, &mesh_transform);
+    if (scene.triangles.empty()) return 1;
     
     // Câmera
-    Point3 cam_pos(0.0f, 1.0f, 3.0f); //MAIS AFASTADA
-    Point3 cam_target(0.0f, 1.0f, 0.0f);
-    Vec3 cam_dir = (cam_target - cam_pos).normalized();
-    Vec3 cam_up(0, 1, 0);
-    Vec3 cam_right = Vec3::cross(cam_dir, cam_up).normalized();
-    cam_up = Vec3::cross(cam_right, cam_dir).normalized();
+    Camera camera(config.cam_pos, config.cam_target, config.fov, config.width, config.height);
     
-    float fov = 40.0f * M_PI / 180.0f;
-    float scale = std::tan(fov * 0.5f);
-    float aspect = static_cast<float>(WIDTH) / HEIGHT;
+    float differential_scale = differential_scale_for(config.spp);
     
-    // Renderização com OpenMP
-    auto start_time = omp_get_wtime();
+    // Hash da cena + câmera + parâmetros que mudam a imagem
+    Hasher hasher;
+    hasher.add(scene_hash(scene));
+    hasher.add(config.cam_pos); hasher.add(config.cam_target); hasher.add(config.fov);
+    hasher.add(integrator_settings.max_depth); hasher.add(integrator_settings.rr_depth); hasher.add(differential_scale);
+    hasher.add(integrator_settings.direct_light); hasher.add(integrator_settings.light_selection);
+    hasher.add(config.width); hasher.add(config.height); hasher.add(config.pass_spp);
+    hasher.add(config.sampler); hasher.add(config.texture_bake_res);
     
-    #pragma omp parallel for schedule(dynamic)
-    for (int y = 0; y < HEIGHT; y++) {
-        for (int x = 0; x < WIDTH; x++) {
-            Color pixel_color(0, 0, 0);
-            
-            for (int s = 0; s < SAMPLES_PER_PIXEL; s++) {
-                float u = (x + random_float()) / WIDTH;
-                float v = (y + random_float()) / HEIGHT;
-                
-                u = (u - 0.5f) * 2.0f;
-                v = (v - 0.5f) * 2.0f;
-                
-                Vec3 ray_dir = (cam_dir + cam_right * (u * scale * aspect) + cam_up * (v * scale)).normalized();
-                Ray r(cam_pos, ray_dir);
-                
-                pixel_color = pixel_color + trace(r, scene, 0);
+    const int total_passes = (config.spp + config.pass_spp - 1) / config.pass_spp;
+    
+    // Só uma região da imagem
+    if (!crop_text.empty() || !dirty_mask.empty()) {
+        std::vector<ShardSpec> tiles;
+        if (!crop_text.empty()) {
+            int x0, y0, x1, y1;
+            if (std::sscanf(crop_text.c_str(), "%d,%d,%d,%d", &x0, &y0, &x1, &y1) != 4 ||
+                x0 < 0 || y0 < 0 || x1 > config.width || y1 > config.height || x0 >= x1 || y0 >= y1) {
+                std::cerr << "ERRO: recorte inválido: " << crop_text << std::endl;
+                return 1;
             }
-            
-            pixel_color = pixel_color / static_cast<float>(SAMPLES_PER_PIXEL);
-            framebuffer[(HEIGHT - 1 - y) * WIDTH + x] = pixel_color;
+            tiles = crop_tiles(x0, y0, x1, y1, total_passes);
+        } else if (!dirty_tiles(dirty_mask, total_passes, tiles)) {
+            return 1;
         }
-        
-        if (y % 32 == 0) {
-            std::cout << "Progresso: " << (100 * y / HEIGHT) << "%\r" << std::flush;
+        return render_region(scene, camera, differential_scale, hasher.value, config.seed, tiles,
+                             composite_path, reference);
+    }
+    
+    // Várias vistas (de uma ou mais cenas)
+    if (!cameras_path.empty()) {
+        std::vector<RenderJob> views;
+        if (!load_views(cameras_path, views)) return 1;
+        return render_views(scene, views);
+    }
+    
+    // Sequência animada
+    if (animation.frames > 0) {
+        animation.set_rest_pose(scene.triangles, mesh_transform);
+        return render_animation(scene, camera, differential_scale, animation, config.seed);
+    }
+    
+    // Shard avulso: só o bloco pedido, gravado no checkpoint
+    if (!shard_text.empty()) {
+        ShardSpec shard;
+        if (!shard.parse(shard_text, config.width, config.height) || shard.pass_end > total_passes) {
+            std::cerr << "ERRO: shard inválido: " << shard_text << std::endl;
+            return 1;
+        }
+        Checkpoint part = render_shard(scene, camera, differential_scale, hasher.value, config.seed, shard, [] {});
+        if (!part.save(checkpoint_path)) {
+            std::cerr << "ERRO: não foi possível gravar " << checkpoint_path << std::endl;
+            return 1;
         }
+        std::cout << "Shard " << shard.to_string() << " salvo em: " << checkpoint_path << std::endl;
+        return 0;
     }
     
-    auto end_time = omp_get_wtime();
-    std::cout << "\nTempo de renderização: " << (end_time - start_time) << " segundos" << std::endl;
+    // Worker de uma fila existente
+    if (!worker_dir.empty()) {
+        WorkQueue queue(worker_dir);
+        return run_queue(queue, scene, camera, differential_scale, hasher.value, false);
+    }
     
-    // Tonemap e salvar PNG
-    std::vector<unsigned char> pixels(WIDTH * HEIGHT * 3);
-    for (int i = 0; i < WIDTH * HEIGHT; i++) {
-        Color c = framebuffer[i];
+    // Coordenador: cria a fila, trabalha junto com os workers e mescla tudo
+    if (!queue_dir.empty()) {
+        WorkQueue queue(queue_dir);
+        int jobs = queue.create(make_shards(config.width, config.height, total_passes, tiles_x, tiles_y, sample_shards),
+                                config.seed, hasher.value, config.to_string());
+        std::cout << "Fila " << queue_dir << ": " << jobs << " shards" << std::endl;
+        
+        auto start_time = omp_get_wtime();
+        spawn_workers(argv[0], queue_dir, spawn);
+        if (run_queue(queue, scene, camera, differential_scale, hasher.value, true) != 0) return 1;
+        std::cout << "Tempo de renderização: " << (omp_get_wtime() - start_time) << " segundos" << std::endl;
         
-        // Clamp
-        c.x = std::clamp(c.x, 0.0f, 1.0f);
-        c.y = std::clamp(c.y, 0.0f, 1.0f);
-        c.z = std::clamp(c.z, 0.0f, 1.0f);
+        Checkpoint merged;
+        if (!merge_files(queue.done_files(), merged)) return 1;
+        if (config.checkpoint && merged.save(checkpoint_path)) {
+            std::cout << "Checkpoint salvo em: " << checkpoint_path << std::endl;
+        }
+        finish_image(merged, config.output, reference);
+        return 0;
+    }
+    
+    // Buffer de acumulação (somas + amostras por pixel)
+    Checkpoint accum;
+    accum.init(config.width, config.height, hasher.value, config.seed, config.pass_spp);
+    if (resume) {
+        Checkpoint saved;
+        if (!saved.load(checkpoint_path)) {
+            std::cerr << "ERRO: não foi possível ler o checkpoint " << checkpoint_path << std::endl;
+            return 1;
+        }
+        if (saved.width != config.width || saved.height != config.height || saved.scene_hash != accum.scene_hash ||
+            saved.pass_spp != static_cast<uint32_t>(config.pass_spp) || saved.first_pass != 0 ||
+            saved.window_w != config.width || saved.window_h != config.height) {
+            std::cerr << "ERRO: o checkpoint é de outra cena ou configuração" << std::endl;
+            return 1;
+        }
+        accum = saved;
+        std::cout << "Retomando de " << checkpoint_path << ": " << accum.passes_done << " passadas concluídas"
+                  << " (semente " << accum.seed << ")" << std::endl;
+    }
+    
+    // Mapa de custo por pixel (só das passadas renderizadas nesta execução)
+    CostMap cost;
+    if (cost_map) cost.init(config.width, config.height);
+    
+    // Renderização com OpenMP
+    auto start_time = omp_get_wtime();
+    const unsigned long long rays_before = total_rays_cast;
+    double last_checkpoint = start_time;
+    
+    // Passadas de pass_spp amostras sobre a imagem inteira; entre passadas o
+    // buffer fica consistente e pode ir para o disco
+    for (int pass = accum.passes_done; pass < total_passes; pass++) {
+        render_pass(scene, camera, differential_scale, accum, 0, 0, config.width, config.height, pass, config.spp,
+                    cost_map ? &cost : nullptr);
+        accum.passes_done = pass + 1;
         
-        // Gamma correction
-        c.x = std::pow(c.x, 1.0f / GAMMA);
-        c.y = std::pow(c.y, 1.0f / GAMMA);
-        c.z = std::pow(c.z, 1.0f / GAMMA);
+        std::cout << "Progresso: " << (100 * accum.passes_done / total_passes) << "%\r" << std::flush;
         
-        pixels[i*3 + 0] = static_cast<unsigned char>(c.x * 255.0f);
-        pixels[i*3 + 1] = static_cast<unsigned char>(c.y * 255.0f);
-        pixels[i*3 + 2] = static_cast<unsigned char>(c.z * 255.0f);
+        double now = omp_get_wtime();
+        if (config.checkpoint && config.checkpoint_interval > 0 && now - last_checkpoint >= config.checkpoint_interval) {
+            if (!accum.save(checkpoint_path)) {
+                std::cerr << "\nAVISO: falha ao gravar o checkpoint " << checkpoint_path << std::endl;
+            }
+            last_checkpoint = now;
+        }
     }
     
-    stbi_write_png("output/render.png", WIDTH, HEIGHT, 3, pixels.data(), WIDTH * 3);
-    std::cout << "Imagem salva em: output/render.png" << std::endl;
+    auto end_time = omp_get_wtime();
+    std::cout << "\nTempo de renderização: " << (end_time - start_time) << " segundos" << std::endl;
+    
+    // Vazão de raios (primários + secundários). O bench compara sort_rays=0 e 1
+    // em cada cena, com as faltas de cache L1d/LLC no Linux.
+    unsigned long long total_rays = total_rays_cast - rays_before;
+    std::cout << "Raios: " << total_rays << " | " << (total_rays / (end_time - start_time) / 1e6)
+              << " Mraios/s" << (config.batched && config.sort_rays ? " (ordenados)" : "") << std::endl;
+    report_stats(config.output);
+    if (cost_map && !cost.write(config.output)) {
+        std::cerr << "AVISO: falha ao gravar o mapa de custo" << std::endl;
+    }
+    
+    // Checkpoint final: permite mesclar mais amostras numa imagem pronta
+    if (config.checkpoint && accum.save(checkpoint_path)) {
+        std::cout << "Checkpoint salvo em: " << checkpoint_path << std::endl;
+    }
     
+    finish_image(accum, config.output, reference);
 
     return 0;
 }